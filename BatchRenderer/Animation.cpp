@@ -0,0 +1,87 @@
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	double Ease(Easing easing, double t)
+	{
+		switch (easing)
+		{
+		case Easing::EASE_IN:
+			return t * t;
+		case Easing::EASE_OUT:
+			return 1.0 - (1.0 - t) * (1.0 - t);
+		case Easing::EASE_IN_OUT:
+			return t * t * (3.0 - 2.0 * t);
+		default:
+			return t;
+		}
+	}
+
+	bool ParseEasing(const std::string& name, Easing& outEasing)
+	{
+		if (name == "linear")
+			outEasing = Easing::LINEAR;
+		else if (name == "in")
+			outEasing = Easing::EASE_IN;
+		else if (name == "out")
+			outEasing = Easing::EASE_OUT;
+		else if (name == "inout")
+			outEasing = Easing::EASE_IN_OUT;
+		else
+			return false;
+		return true;
+	}
+}
+
+double Keyframe::GetZoom(int frame) const
+{
+	const double t = frames > 1 ? static_cast<double>(frame) / (frames - 1) : 0.0;
+	return startZoom * std::pow(endZoom / startZoom, Ease(easing, t));
+}
+
+double Keyframe::GetDeepestZoom() const
+{
+	return std::max(startZoom, endZoom);
+}
+
+bool LoadKeyframes(const std::string& path, std::vector<Keyframe>& outKeyframes, std::string& outError)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		outError = "cannot open " + path;
+		return false;
+	}
+
+	outKeyframes.clear();
+	std::string line;
+	for (int number = 1; std::getline(file, line); ++number)
+	{
+		std::istringstream stream(line);
+		Keyframe keyframe;
+		if (!(stream >> keyframe.centerX) || keyframe.centerX[0] == '#')
+			continue;
+
+		std::string easing = "linear";
+		const bool parsed = static_cast<bool>(stream >> keyframe.centerY >> keyframe.startZoom >> keyframe.endZoom >> keyframe.frames);
+		stream >> easing;
+		if (!parsed || keyframe.startZoom <= 0.0 || keyframe.endZoom <= 0.0 || keyframe.frames <= 0 || !ParseEasing(easing, keyframe.easing))
+		{
+			outError = path + ":" + std::to_string(number) + ": expected <center x> <center y> <start zoom> <end zoom> <frames> [linear|in|out|inout]";
+			return false;
+		}
+		outKeyframes.push_back(keyframe);
+	}
+
+	if (outKeyframes.empty())
+	{
+		outError = path + ": no keyframes";
+		return false;
+	}
+	return true;
+}
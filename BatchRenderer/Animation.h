@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum class Easing
+{
+	LINEAR,
+	EASE_IN,
+	EASE_OUT,
+	EASE_IN_OUT,
+};
+
+// A zoom from `startZoom` to `endZoom` around one center over `frames` frames.
+// The zoom changes exponentially, so a linear easing zooms by the same factor every frame.
+struct Keyframe
+{
+	// decimal text, parsed to the deep position by the renderer
+	std::string centerX;
+	std::string centerY;
+	double startZoom = 1.0;
+	double endZoom = 1.0;
+	int frames = 1;
+	Easing easing = Easing::LINEAR;
+
+	double GetZoom(int frame) const;
+	double GetDeepestZoom() const;
+};
+
+// One keyframe per line: <center x> <center y> <start zoom> <end zoom> <frames> [linear|in|out|inout].
+// Empty lines and lines starting with # are skipped. Reports the first bad line to `outError`.
+bool LoadKeyframes(const std::string& path, std::vector<Keyframe>& outKeyframes, std::string& outError);
@@ -0,0 +1,617 @@
+// Headless CPU renderer for scripted runs: renders one frame with every hardware thread and writes it to a file.
+// Frames too large for memory are rendered in horizontal bands that are streamed to the file one after another,
+// or with --mapped in one job straight into a memory-mapped BMP, with the values in a PFM file next to it.
+// With --keyframes it renders a zoom animation instead, the output is then a pattern like frame_%05d.png.
+// With --expmap as well the keyframes share one center, the frames are resampled from an exponential map of the zoom.
+// With --trace the render jobs are recorded as a Chrome trace-event timeline, see Trace.h.
+// With --supersample the pixels that differ sharply from a neighbour get up to that many jittered sub-samples.
+// Usage: BatchRenderer --center <x> <y> --zoom <zoom> --iterations <n> --size <width>x<height> --output <file.ppm|file.png|file.bmp>
+//        [--engine standard|perturbation|double-double] [--threshold <value>] [--gray] [--threads <n>] [--band-rows <n>] [--mapped]
+//        [--keyframes <file> [--expmap]] [--trace <file.json>] [--supersample <n>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Data/RenderConfig.h"
+#include "Graphics/MandelbrotCPURender.h"
+#include "Graphics/Palette.h"
+#include "Logger/Logger.h"
+#include "Logger/ConsoleLogger.h"
+#include "Trace/Trace.h"
+#include "ImageWriter.h"
+#include "Animation.h"
+#include "ExpMap.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// memory of a band in the renderer: RGB and the value planes of both color modes
+	const size_t s_bytesPerPixel = 3 + 2 * sizeof(float);
+	// bands are sized to stay under this, whatever the size of the image
+	const size_t s_maxBandBytes = size_t(256) << 20;
+
+	struct Options
+	{
+		std::string centerX = "0";
+		std::string centerY = "0";
+		double zoom = 1.0;
+		int maxIterations = 512;
+		int width = 1920;
+		int height = 1080;
+		std::string output;
+		CPUEngine engine = CPUEngine::STANDARD;
+		float threshold = 65535.0f;
+		bool color = true;
+		size_t threadCount = 0;
+		// rows rendered at once, 0 - as many as fit in s_maxBandBytes
+		int bandRows = 0;
+		// render into mapped files instead of streaming bands
+		bool mapped = false;
+		// animation keyframes, see LoadKeyframes
+		std::string keyframes;
+		// resample the animation frames from an exponential map, see ExpMap
+		bool expMap = false;
+		// trace-event JSON of the run, empty - no trace
+		std::string trace;
+		// most sub-samples of a pixel, 0 - no supersampling
+		int maxSubsamples = 0;
+	};
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr,
+			"Usage: BatchRenderer --center <x> <y> --zoom <zoom> --iterations <n> --size <width>x<height> --output <file.ppm|file.png|file.bmp>\n"
+			"                     [--engine standard|perturbation|double-double] [--threshold <value>] [--gray] [--threads <n>] [--band-rows <n>] [--mapped]\n"
+			"                     [--keyframes <file> [--expmap]] [--trace <file.json>] [--supersample <n>]\n"
+			"A .bmp output needs --mapped and a width that is a multiple of 4, the values go to a .pfm file of the same name.\n"
+			"Keyframes are lines of <center x> <center y> <start zoom> <end zoom> <frames> [linear|in|out|inout],\n"
+			"the output is then a pattern with one integer conversion such as frame_%%05d.png.\n"
+			"--expmap resamples the frames from one log-polar strip per zoom octave, the keyframes have to share the center.\n"
+			"--trace records the render jobs as trace events, the file opens in https://ui.perfetto.dev or chrome://tracing.\n"
+			"--supersample adds up to n jittered sub-samples to the pixels that differ sharply from a neighbour, at most 64.\n");
+	}
+
+	bool ParseEngine(const std::string& name, CPUEngine& outEngine)
+	{
+		if (name == "standard")
+			outEngine = CPUEngine::STANDARD;
+		else if (name == "perturbation")
+			outEngine = CPUEngine::PERTURBATION;
+		else if (name == "double-double")
+			outEngine = CPUEngine::DOUBLE_DOUBLE;
+		else
+			return false;
+		return true;
+	}
+
+	// one %d conversion, optionally zero-padded to a width, and no other conversions
+	bool IsFramePattern(const std::string& pattern)
+	{
+		const size_t percent = pattern.find('%');
+		if (percent == std::string::npos || pattern.find('%', percent + 1) != std::string::npos)
+			return false;
+
+		const size_t conversion = pattern.find_first_not_of("0123456789", percent + 1);
+		return conversion != std::string::npos && pattern[conversion] == 'd';
+	}
+
+	std::string GetFramePath(const std::string& pattern, int frame)
+	{
+		const int length = std::snprintf(nullptr, 0, pattern.c_str(), frame);
+		std::string path(static_cast<size_t>(length) + 1, '\0');
+		std::snprintf(path.data(), path.size(), pattern.c_str(), frame);
+		path.resize(static_cast<size_t>(length));
+		return path;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			// number of values that have to follow the option
+			const int values = arg == "--center" ? 2 : (arg == "--gray" || arg == "--mapped" || arg == "--expmap" ? 0 : 1);
+			if (i + values >= argc)
+			{
+				std::fprintf(stderr, "Missing value of %s\n", arg.c_str());
+				return false;
+			}
+
+			if (arg == "--center")
+			{
+				options.centerX = argv[++i];
+				options.centerY = argv[++i];
+			}
+			else if (arg == "--zoom")
+			{
+				options.zoom = std::atof(argv[++i]);
+			}
+			else if (arg == "--iterations")
+			{
+				options.maxIterations = std::atoi(argv[++i]);
+			}
+			else if (arg == "--size")
+			{
+				if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2)
+				{
+					std::fprintf(stderr, "Size has to be <width>x<height>\n");
+					return false;
+				}
+			}
+			else if (arg == "--output")
+			{
+				options.output = argv[++i];
+			}
+			else if (arg == "--engine")
+			{
+				if (!ParseEngine(argv[++i], options.engine))
+				{
+					std::fprintf(stderr, "Unknown engine %s\n", argv[i]);
+					return false;
+				}
+			}
+			else if (arg == "--threshold")
+			{
+				options.threshold = static_cast<float>(std::atof(argv[++i]));
+			}
+			else if (arg == "--gray")
+			{
+				options.color = false;
+			}
+			else if (arg == "--threads")
+			{
+				options.threadCount = static_cast<size_t>(std::max(std::atoi(argv[++i]), 1));
+			}
+			else if (arg == "--band-rows")
+			{
+				options.bandRows = std::max(std::atoi(argv[++i]), 0);
+			}
+			else if (arg == "--mapped")
+			{
+				options.mapped = true;
+			}
+			else if (arg == "--keyframes")
+			{
+				options.keyframes = argv[++i];
+			}
+			else if (arg == "--expmap")
+			{
+				options.expMap = true;
+			}
+			else if (arg == "--trace")
+			{
+				options.trace = argv[++i];
+			}
+			else if (arg == "--supersample")
+			{
+				options.maxSubsamples = std::max(std::atoi(argv[++i]), 0);
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (options.mapped ? !ImageWriter::HasExtension(options.output, ".bmp") : !ImageWriter::IsSupported(options.output))
+		{
+			std::fprintf(stderr, options.mapped ? "Mapped output has to be a .bmp file\n" : "Output has to be a .ppm or .png file\n");
+			return false;
+		}
+		if (!options.keyframes.empty() && (options.mapped || !IsFramePattern(options.output)))
+		{
+			std::fprintf(stderr, "Animation output has to be a .ppm or .png pattern with one integer conversion, e.g. frame_%%05d.png\n");
+			return false;
+		}
+		if (options.expMap && options.keyframes.empty())
+		{
+			std::fprintf(stderr, "Exponential map needs --keyframes\n");
+			return false;
+		}
+		if (options.mapped && options.width % 4 != 0)
+		{
+			// the frame is written in place, BMP rows would need padding
+			std::fprintf(stderr, "Mapped output needs a width that is a multiple of 4\n");
+			return false;
+		}
+		if (options.zoom <= 0.0 || options.maxIterations <= 0 || options.width <= 0 || options.height <= 0)
+		{
+			std::fprintf(stderr, "Zoom, iterations and size have to be positive\n");
+			return false;
+		}
+		return true;
+	}
+
+	// Same defaults as ToolsUI, the view comes from the options
+	bool SetCenter(const std::string& textX, const std::string& textY, RenderConfig& config)
+	{
+		math::deepfixed centerX, centerY;
+		if (!math::deepfixed::fromString(textX, centerX) || !math::deepfixed::fromString(textY, centerY))
+		{
+			std::fprintf(stderr, "Center has to be two decimal numbers, got %s %s\n", textX.c_str(), textY.c_str());
+			return false;
+		}
+
+		// the render position is the negated center of the view
+		config.m_deepPosition = math::vec2<math::deepfixed>(-centerX, -centerY);
+		config.m_position = math::vec2d(config.m_deepPosition.x.toDouble(), config.m_deepPosition.y.toDouble());
+		return true;
+	}
+
+	bool MakeConfig(const Options& options, RenderConfig& config)
+	{
+		if (!SetCenter(options.centerX, options.centerY, config))
+			return false;
+
+		config.m_zoom = options.zoom;
+		config.m_maxIterations = options.maxIterations;
+		config.m_threshold = options.threshold;
+		config.m_windowSize = math::vec2f(static_cast<float>(options.width), static_cast<float>(options.height));
+		config.m_useCPU = true;
+		config.m_colorEnabled = options.color;
+		config.m_paletteOffset = OFFSET_COLOR;
+		// whole rows in mapped files: the workers fill the pages in order
+		config.m_tileSize = options.mapped ? 0 : 64;
+		config.m_cpuEngine = options.engine;
+		config.m_blaEnabled = true;
+		config.m_periodicityEnabled = true;
+		config.m_maxSubsamples = options.maxSubsamples;
+		return true;
+	}
+
+	// The view of `rows` image rows starting `top` rows below the top edge, with the pixel centers of the whole image.
+	// c = scale * (2 * pixel - resolution) / resolution.y - position: the zoom keeps the pixel size at the band height
+	// and the position moves to the middle of the band.
+	RenderConfig MakeBandConfig(const RenderConfig& image, int top, int rows)
+	{
+		const double height = image.m_windowSize.height;
+		const double pixelSize = 2.0 / (image.m_zoom * height);
+		// pixel rows count from the bottom edge
+		const double bottom = height - top - rows;
+
+		RenderConfig band = image;
+		band.m_windowSize.height = static_cast<float>(rows);
+		band.m_zoom = image.m_zoom * height / rows;
+		const double shift = (2.0 * bottom + rows - height) * 0.5 * pixelSize;
+		band.m_deepPosition.y = image.m_deepPosition.y - math::deepfixed(shift);
+		band.m_position.y = band.m_deepPosition.y.toDouble();
+		return band;
+	}
+
+	// the renderer keeps BGR, the image files take RGB
+	void ToRGB(const unsigned char* bgr, size_t width, std::vector<unsigned char>& outRGB)
+	{
+		outRGB.resize(width * 3);
+		for (size_t x = 0; x < width; ++x)
+		{
+			outRGB[x * 3 + 0] = bgr[x * 3 + 2];
+			outRGB[x * 3 + 1] = bgr[x * 3 + 1];
+			outRGB[x * 3 + 2] = bgr[x * 3 + 0];
+		}
+	}
+
+	// `rows` BGR rows from the bottom one, as the renderer keeps them
+	bool WriteFrameRows(ImageWriter& writer, const unsigned char* data, int width, int rows)
+	{
+		std::vector<unsigned char> row;
+		const size_t rowBytes = static_cast<size_t>(width) * 3;
+		for (int y = rows - 1; y >= 0; --y)
+		{
+			ToRGB(data + y * rowBytes, width, row);
+			if (!writer.WriteRows(row.data(), 1))
+				return false;
+		}
+		return true;
+	}
+
+	bool WriteFrame(const std::string& path, const unsigned char* data, const math::vec2i& size)
+	{
+		ImageWriter writer;
+		return writer.Open(path, size.x, size.y) && WriteFrameRows(writer, data, size.x, size.y) && writer.Close();
+	}
+
+	int GetBandRows(const Options& options)
+	{
+		if (options.bandRows > 0)
+			return std::min(options.bandRows, options.height);
+
+		const size_t rowBytes = static_cast<size_t>(options.width) * s_bytesPerPixel;
+		return static_cast<int>(std::clamp<size_t>(s_maxBandBytes / rowBytes, 1, static_cast<size_t>(options.height)));
+	}
+
+	void PrintThroughput(const Options& options, int frames, double seconds, size_t threadCount, const char* layout)
+	{
+		const double pixels = static_cast<double>(options.width) * options.height * frames;
+		char count[32] = "";
+		if (frames > 1)
+		{
+			std::snprintf(count, sizeof(count), "%d frames of ", frames);
+		}
+		std::printf("Rendered %s%dx%d in %.3f s on %zu threads (%s), %.2f Mpix/s\n", count, options.width, options.height, seconds, threadCount, layout, pixels / seconds * 1e-6);
+	}
+
+	int RenderBands(const Options& options, const RenderConfig& config, size_t threadCount)
+	{
+		const int bandRows = GetBandRows(options);
+		const int bandCount = (options.height + bandRows - 1) / bandRows;
+		ImageWriter writer;
+		if (!writer.Open(options.output, options.width, options.height))
+		{
+			std::fprintf(stderr, "Failed to open %s\n", options.output.c_str());
+			return 1;
+		}
+
+		MandelbrotCPURender render(threadCount);
+		auto bandConfig = std::make_shared<RenderConfig>();
+		render.BindData(bandConfig);
+
+		int result = 0;
+		double seconds = 0.0;
+		for (int top = 0; top < options.height && result == 0; top += bandRows)
+		{
+			const int rows = std::min(bandRows, options.height - top);
+			*bandConfig = MakeBandConfig(config, top, rows);
+
+			const Clock::time_point start = Clock::now();
+			render.OnUpdate();
+			render.Wait();
+			seconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+			result = WriteFrameRows(writer, render.GetFrameData(), options.width, rows) ? 0 : 1;
+		}
+
+		if (!writer.Close() || result != 0)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+			return 1;
+		}
+
+		char layout[64];
+		std::snprintf(layout, sizeof(layout), "%d bands of %d rows", bandCount, bandRows);
+		PrintThroughput(options, 1, seconds, threadCount, layout);
+		return 0;
+	}
+
+	// The frame is rendered in place into the output, there is nothing to write out
+	int RenderMapped(const Options& options, const RenderConfig& config, size_t threadCount)
+	{
+		const std::string valuesPath = options.output.substr(0, options.output.size() - 4) + ".pfm";
+
+		MandelbrotCPURender render(threadCount);
+		render.SetMappedStorage(options.output, valuesPath);
+		auto frameConfig = std::make_shared<RenderConfig>(config);
+		render.BindData(frameConfig);
+
+		const Clock::time_point start = Clock::now();
+		render.OnUpdate();
+		render.Wait();
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (!render.IsFrameMapped())
+		{
+			std::fprintf(stderr, "Failed to map %s\n", options.output.c_str());
+			return 1;
+		}
+
+		PrintThroughput(options, 1, seconds, threadCount, "mapped");
+		return 0;
+	}
+
+	// Frames of a keyframe share its center: the reference orbit is computed once for the deepest of them
+	// and serves every frame. A frame is written to disk while the next one renders.
+	int RenderAnimation(const Options& options, const RenderConfig& config, size_t threadCount)
+	{
+		std::vector<Keyframe> keyframes;
+		std::string error;
+		if (!LoadKeyframes(options.keyframes, keyframes, error))
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+
+		MandelbrotCPURender render(threadCount);
+		auto frameConfig = std::make_shared<RenderConfig>(config);
+		render.BindData(frameConfig);
+
+		std::future<bool> pendingWrite;
+		std::string pendingPath;
+		const auto finishWrite = [&pendingWrite, &pendingPath]()
+		{
+			if (pendingWrite.valid() && !pendingWrite.get())
+			{
+				std::fprintf(stderr, "Failed to write %s\n", pendingPath.c_str());
+				return false;
+			}
+			return true;
+		};
+
+		int frameNumber = 0;
+		double seconds = 0.0;
+		for (const Keyframe& keyframe : keyframes)
+		{
+			if (!SetCenter(keyframe.centerX, keyframe.centerY, *frameConfig))
+			{
+				finishWrite();
+				return 1;
+			}
+			render.SetDeepestZoom(keyframe.GetDeepestZoom());
+
+			for (int frame = 0; frame < keyframe.frames; ++frame, ++frameNumber)
+			{
+				frameConfig->m_zoom = keyframe.GetZoom(frame);
+
+				const Clock::time_point start = Clock::now();
+				render.OnUpdate();
+				render.Wait();
+				seconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+				if (!finishWrite())
+					return 1;
+
+				// the writer gets its own copy, the renderer draws the next frame into the same buffer
+				const math::vec2i size = render.GetFrameSize();
+				const unsigned char* data = render.GetFrameData();
+				std::vector<unsigned char> frameData(data, data + static_cast<size_t>(size.x) * size.y * 3);
+				pendingPath = GetFramePath(options.output, frameNumber);
+				pendingWrite = std::async(std::launch::async, [path = pendingPath, frameData = std::move(frameData), size]()
+				{
+					return WriteFrame(path, frameData.data(), size);
+				});
+			}
+		}
+
+		if (!finishWrite())
+			return 1;
+
+		PrintThroughput(options, frameNumber, seconds, threadCount, "animation");
+		return 0;
+	}
+
+	// The strips are rendered from the deepest one, so the reference orbit computed for it serves the others
+	// and the center frame. The frames are resampled on a pool of their own and written while the next one is resampled.
+	int RenderExpMap(const Options& options, const RenderConfig& config, size_t threadCount)
+	{
+		std::vector<Keyframe> keyframes;
+		std::string error;
+		if (!LoadKeyframes(options.keyframes, keyframes, error))
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+
+		double startZoom = keyframes.front().startZoom;
+		double endZoom = startZoom;
+		for (const Keyframe& keyframe : keyframes)
+		{
+			if (keyframe.centerX != keyframes.front().centerX || keyframe.centerY != keyframes.front().centerY)
+			{
+				std::fprintf(stderr, "Keyframes of an exponential map have to share the center\n");
+				return 1;
+			}
+			startZoom = std::min({ startZoom, keyframe.startZoom, keyframe.endZoom });
+			endZoom = std::max({ endZoom, keyframe.startZoom, keyframe.endZoom });
+		}
+
+		const math::vec2i frameSize(options.width, options.height);
+		ExpMap expMap(frameSize, startZoom, endZoom);
+		const math::vec2i& stripSize = expMap.GetStripSize();
+
+		const Clock::time_point renderStart = Clock::now();
+		{
+			MandelbrotCPURender render(threadCount);
+			auto viewConfig = std::make_shared<RenderConfig>(config);
+			if (!SetCenter(keyframes.front().centerX, keyframes.front().centerY, *viewConfig))
+				return 1;
+			render.BindData(viewConfig);
+
+			viewConfig->m_exponentialMap = true;
+			viewConfig->m_windowSize = math::vec2f(static_cast<float>(stripSize.x), static_cast<float>(stripSize.y));
+			for (int strip = expMap.GetStripCount() - 1; strip >= 0; --strip)
+			{
+				viewConfig->m_zoom = expMap.GetStripZoom(strip);
+				render.OnUpdate();
+				render.Wait();
+				expMap.SetStrip(strip, render.GetFrameData());
+			}
+
+			viewConfig->m_exponentialMap = false;
+			viewConfig->m_windowSize = config.m_windowSize;
+			viewConfig->m_zoom = expMap.GetCenterZoom();
+			render.OnUpdate();
+			render.Wait();
+			expMap.SetCenterFrame(render.GetFrameData());
+		}
+		const double renderSeconds = std::chrono::duration<double>(Clock::now() - renderStart).count();
+
+		ThreadPool pool(threadCount);
+		std::future<bool> pendingWrite;
+		std::string pendingPath;
+		const auto finishWrite = [&pendingWrite, &pendingPath]()
+		{
+			if (pendingWrite.valid() && !pendingWrite.get())
+			{
+				std::fprintf(stderr, "Failed to write %s\n", pendingPath.c_str());
+				return false;
+			}
+			return true;
+		};
+
+		int frameNumber = 0;
+		double resampleSeconds = 0.0;
+		for (const Keyframe& keyframe : keyframes)
+		{
+			for (int frame = 0; frame < keyframe.frames; ++frame, ++frameNumber)
+			{
+				std::vector<unsigned char> frameData;
+				const Clock::time_point start = Clock::now();
+				expMap.ResampleFrame(keyframe.GetZoom(frame), pool, frameData);
+				resampleSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+				if (!finishWrite())
+					return 1;
+
+				pendingPath = GetFramePath(options.output, frameNumber);
+				pendingWrite = std::async(std::launch::async, [path = pendingPath, frameData = std::move(frameData), frameSize]()
+				{
+					return WriteFrame(path, frameData.data(), frameSize);
+				});
+			}
+		}
+
+		if (!finishWrite())
+			return 1;
+
+		std::printf("Rendered %d strips of %dx%d and the center frame in %.3f s, resampled the frames in %.3f s\n",
+			expMap.GetStripCount(), stripSize.x, stripSize.y, renderSeconds, resampleSeconds);
+		PrintThroughput(options, frameNumber, renderSeconds + resampleSeconds, threadCount, "exponential map");
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	auto config = std::make_shared<RenderConfig>();
+	if (!MakeConfig(options, *config))
+		return 1;
+
+	Logger::MakeInstance();
+	Logger::AddLoger(new ConsoleLogger());
+
+	// no UI thread to leave a core to
+	const size_t threadCount = options.threadCount > 0 ? options.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+	if (!options.trace.empty())
+	{
+		Trace::SetThreadName("Main thread");
+		Trace::Start(options.trace);
+	}
+
+	int result = options.expMap ? RenderExpMap(options, *config, threadCount)
+		: !options.keyframes.empty() ? RenderAnimation(options, *config, threadCount)
+		: options.mapped ? RenderMapped(options, *config, threadCount)
+		: RenderBands(options, *config, threadCount);
+
+	if (!options.trace.empty() && !Trace::Stop())
+	{
+		result = 1;
+	}
+
+	Logger::FreeInstance();
+
+	return result;
+}
@@ -0,0 +1,185 @@
+#include "ExpMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Threading/ThreadPool.h"
+
+const int ExpMap::s_rowsPerTask = 16;
+
+ExpMap::ExpMap(const math::vec2i& frameSize, double startZoom, double endZoom)
+	: m_frameSize(frameSize)
+	, m_stripSize()
+	, m_firstStripZoom(0.0)
+	, m_centerZoom(endZoom)
+	, m_innerRadius(0.0)
+	, m_strips()
+	, m_centerFrame()
+	, m_pixelColumns()
+	, m_pixelOctaves()
+{
+	// the outer row is as dense as the pixels at the corners of the frames it serves, the rows are as far apart
+	const double diagonal = std::hypot(static_cast<double>(frameSize.x), static_cast<double>(frameSize.y));
+	m_stripSize.x = static_cast<int>(std::ceil(std::numbers::pi * diagonal));
+	m_stripSize.y = static_cast<int>(std::ceil(m_stripSize.x * std::numbers::ln2 / (2.0 * std::numbers::pi)));
+
+	// strip 0 reaches the corners of the start frame, the last one the circle inside the deepest frame
+	const double cornerRatio = diagonal / frameSize.y;
+	m_firstStripZoom = startZoom / cornerRatio;
+	const int stripCount = std::max(static_cast<int>(std::ceil(std::log2(cornerRatio * endZoom / startZoom))), 1);
+	m_innerRadius = std::exp2(-stripCount) / m_firstStripZoom;
+	m_strips.resize(static_cast<size_t>(stripCount));
+
+	// a zoom only scales the distances, the angles and the logarithms are computed once
+	const size_t pixelCount = static_cast<size_t>(frameSize.x) * frameSize.y;
+	m_pixelColumns.resize(pixelCount);
+	m_pixelOctaves.resize(pixelCount);
+	const math::vec2d resolution(frameSize.x, frameSize.y);
+	for (int y = 0; y < frameSize.y; ++y)
+	{
+		for (int x = 0; x < frameSize.x; ++x)
+		{
+			// the pixel mapping of the renderer around the center
+			const math::vec2d offset = (2.0 * math::vec2d(x, y) - resolution) / resolution.y;
+			const double column = std::atan2(offset.y, offset.x) / (2.0 * std::numbers::pi) * m_stripSize.x;
+			const size_t pixel = static_cast<size_t>(y) * frameSize.x + x;
+			m_pixelColumns[pixel] = static_cast<float>(column < 0.0 ? column + m_stripSize.x : column);
+			m_pixelOctaves[pixel] = static_cast<float>(0.5 * std::log2(math::dot(offset, offset)));
+		}
+	}
+}
+
+int ExpMap::GetStripCount() const
+{
+	return static_cast<int>(m_strips.size());
+}
+
+const math::vec2i& ExpMap::GetStripSize() const
+{
+	return m_stripSize;
+}
+
+double ExpMap::GetStripZoom(int strip) const
+{
+	return std::ldexp(m_firstStripZoom, strip);
+}
+
+double ExpMap::GetCenterZoom() const
+{
+	return m_centerZoom;
+}
+
+void ExpMap::SetStrip(int strip, const unsigned char* data)
+{
+	m_strips[strip].assign(data, data + static_cast<size_t>(m_stripSize.x) * m_stripSize.y * 3);
+}
+
+void ExpMap::SetCenterFrame(const unsigned char* data)
+{
+	m_centerFrame.assign(data, data + static_cast<size_t>(m_frameSize.x) * m_frameSize.y * 3);
+}
+
+void ExpMap::ResampleFrame(double zoom, ThreadPool& pool, std::vector<unsigned char>& outData) const
+{
+	outData.resize(static_cast<size_t>(m_frameSize.x) * m_frameSize.y * 3);
+
+	TaskGroup tasks(pool);
+	for (int row = 0; row < m_frameSize.y; row += s_rowsPerTask)
+	{
+		const int rowCount = std::min(s_rowsPerTask, m_frameSize.y - row);
+		unsigned char* data = outData.data();
+		tasks.Run([this, zoom, row, rowCount, data]() { ResampleRows(zoom, row, rowCount, data); });
+	}
+	tasks.Wait();
+}
+
+void ExpMap::ResampleRows(double zoom, int firstRow, int rowCount, unsigned char* outData) const
+{
+	const math::vec2d resolution(m_frameSize.x, m_frameSize.y);
+	const double zoomOctave = std::log2(m_firstStripZoom / zoom) + 1.0;
+	const double innerOctave = std::log2(m_innerRadius * m_firstStripZoom) + 1.0;
+	for (int y = firstRow; y < firstRow + rowCount; ++y)
+	{
+		unsigned char* row = outData + static_cast<size_t>(y) * m_frameSize.x * 3;
+		for (int x = 0; x < m_frameSize.x; ++x)
+		{
+			const size_t pixel = static_cast<size_t>(y) * m_frameSize.x + x;
+			const double octave = m_pixelOctaves[pixel] + zoomOctave;
+
+			float color[3];
+			if (octave < innerOctave)
+			{
+				const math::vec2d offset = (2.0 * math::vec2d(x, y) - resolution) / (resolution.y * zoom);
+				SampleCenterFrame(offset, color);
+			}
+			else
+			{
+				SampleStrips(octave, m_pixelColumns[pixel], color);
+			}
+
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				row[x * 3 + channel] = static_cast<unsigned char>(color[channel] + 0.5f);
+			}
+		}
+	}
+}
+
+void ExpMap::SampleStrips(double octave, float column, float* outColor) const
+{
+	const int width = m_stripSize.x;
+	const int height = m_stripSize.y;
+	const size_t rowBytes = static_cast<size_t>(width) * 3;
+
+	// row y of strip k is at radius 2^(y / height - 1 - k) / m_firstStripZoom, column x at angle 2 * pi * x / width
+	int strip = -static_cast<int>(std::floor(octave));
+	double row = (octave + strip) * height;
+	if (strip < 0)
+	{
+		// the corners of the start frame, up to rounding
+		strip = 0;
+		row = height - 1;
+	}
+	const int row0 = std::min(static_cast<int>(row), height - 1);
+	const int column0 = static_cast<int>(column) % width;
+	const int column1 = (column0 + 1) % width;
+	const float fy = static_cast<float>(row - row0);
+	const float fx = column - std::floor(column);
+
+	// the row past the last one is the first row of the next strip outwards
+	const unsigned char* lower = m_strips[strip].data() + row0 * rowBytes;
+	const unsigned char* upper = row0 + 1 < height ? lower + rowBytes : strip > 0 ? m_strips[strip - 1].data() : lower;
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		const float bottom = lower[column0 * 3 + channel] + (lower[column1 * 3 + channel] - lower[column0 * 3 + channel]) * fx;
+		const float top = upper[column0 * 3 + channel] + (upper[column1 * 3 + channel] - upper[column0 * 3 + channel]) * fx;
+		outColor[channel] = bottom + (top - bottom) * fy;
+	}
+}
+
+void ExpMap::SampleCenterFrame(const math::vec2d& offset, float* outColor) const
+{
+	const int width = m_frameSize.x;
+	const int height = m_frameSize.y;
+
+	// offset = (2 * pixel - resolution) / (resolution.y * zoom) solved for the pixel of the center frame
+	const double x = std::clamp((offset.x * m_centerZoom * height + width) * 0.5, 0.0, width - 1.0);
+	const double y = std::clamp((offset.y * m_centerZoom * height + height) * 0.5, 0.0, height - 1.0);
+
+	const int x0 = static_cast<int>(x);
+	const int y0 = static_cast<int>(y);
+	const int x1 = std::min(x0 + 1, width - 1);
+	const int y1 = std::min(y0 + 1, height - 1);
+	const float fx = static_cast<float>(x - x0);
+	const float fy = static_cast<float>(y - y0);
+
+	const unsigned char* lower = m_centerFrame.data() + static_cast<size_t>(y0) * width * 3;
+	const unsigned char* upper = m_centerFrame.data() + static_cast<size_t>(y1) * width * 3;
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		const float bottom = lower[x0 * 3 + channel] + (lower[x1 * 3 + channel] - lower[x0 * 3 + channel]) * fx;
+		const float top = upper[x0 * 3 + channel] + (upper[x1 * 3 + channel] - upper[x0 * 3 + channel]) * fx;
+		outColor[channel] = bottom + (top - bottom) * fy;
+	}
+}
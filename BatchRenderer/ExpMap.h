@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/vec.h"
+
+class ThreadPool;
+
+// A zoom around one fixed center kept as an exponential map: one log-polar strip per octave of the zoom
+// (see RenderConfig::m_exponentialMap) and a plain frame at the deepest zoom for the middle, which the strips
+// would only reach with ever more octaves. A strip costs about as much as one frame, the output frames are
+// resampled from the strips, so an octave of the video costs one frame of iterations instead of dozens.
+class ExpMap
+{
+public:
+	// The strips cover the frames of `frameSize` from `startZoom` to the deeper `endZoom`
+	ExpMap(const math::vec2i& frameSize, double startZoom, double endZoom);
+
+	int GetStripCount() const;
+	const math::vec2i& GetStripSize() const;
+	// m_zoom of the strip view, strip 0 is the outermost one
+	double GetStripZoom(int strip) const;
+	// m_zoom of the frame in the middle, the deepest frame
+	double GetCenterZoom() const;
+
+	// BGR rows from the bottom one, as the renderer keeps them
+	void SetStrip(int strip, const unsigned char* data);
+	void SetCenterFrame(const unsigned char* data);
+
+	// The frame at `zoom` from the start to the end zoom, in BGR rows from the bottom one as well
+	void ResampleFrame(double zoom, ThreadPool& pool, std::vector<unsigned char>& outData) const;
+
+private:
+	void ResampleRows(double zoom, int firstRow, int rowCount, unsigned char* outData) const;
+	// Bilinear samples at `octave` = log2(radius * m_firstStripZoom) + 1 and `column` of the strips,
+	// or around the offset from the center in the complex plane
+	void SampleStrips(double octave, float column, float* outColor) const;
+	void SampleCenterFrame(const math::vec2d& offset, float* outColor) const;
+
+	math::vec2i m_frameSize;
+	math::vec2i m_stripSize;
+	double m_firstStripZoom;
+	double m_centerZoom;
+	// radius below which the center frame is sampled
+	double m_innerRadius;
+	std::vector<std::vector<unsigned char>> m_strips;
+	std::vector<unsigned char> m_centerFrame;
+	// the same for every frame: strip column of each pixel and log2 of its distance from the center at zoom 1
+	std::vector<float> m_pixelColumns;
+	std::vector<float> m_pixelOctaves;
+
+	static const int s_rowsPerTask;
+};
@@ -0,0 +1,208 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+	const size_t s_maxStoredBlock = 65535;
+	const uint32_t s_adlerModulo = 65521;
+
+	void PutBigEndian(std::vector<unsigned char>& out, uint32_t value)
+	{
+		out.push_back(static_cast<unsigned char>(value >> 24));
+		out.push_back(static_cast<unsigned char>(value >> 16));
+		out.push_back(static_cast<unsigned char>(value >> 8));
+		out.push_back(static_cast<unsigned char>(value));
+	}
+}
+
+ImageWriter::ImageWriter()
+	: m_file(nullptr)
+	, m_format(Format::PPM)
+	, m_width(0)
+	, m_height(0)
+	, m_rowsWritten(0)
+	, m_adlerA(1)
+	, m_adlerB(0)
+{
+}
+
+ImageWriter::~ImageWriter()
+{
+	if (m_file)
+	{
+		std::fclose(m_file);
+	}
+}
+
+bool ImageWriter::Open(const std::string& path, int width, int height)
+{
+	if (m_file || width <= 0 || height <= 0 || !IsSupported(path))
+		return false;
+
+	m_file = std::fopen(path.c_str(), "wb");
+	if (!m_file)
+		return false;
+
+	m_format = HasExtension(path, ".png") ? Format::PNG : Format::PPM;
+	m_width = width;
+	m_height = height;
+	m_rowsWritten = 0;
+	m_adlerA = 1;
+	m_adlerB = 0;
+
+	if (m_format == Format::PPM)
+	{
+		return std::fprintf(m_file, "P6\n%d %d\n255\n", width, height) > 0;
+	}
+
+	static const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if (std::fwrite(signature, 1, sizeof(signature), m_file) != sizeof(signature))
+		return false;
+
+	// 8-bit RGB, deflate, adaptive filtering (every row uses filter 0), no interlace
+	std::vector<unsigned char> header;
+	PutBigEndian(header, static_cast<uint32_t>(width));
+	PutBigEndian(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+	if (!WriteChunk("IHDR", header.data(), header.size()))
+		return false;
+
+	// zlib header: deflate with a 32K window, no dictionary, fastest level
+	static const unsigned char zlibHeader[] = { 0x78, 0x01 };
+	return WriteChunk("IDAT", zlibHeader, sizeof(zlibHeader));
+}
+
+bool ImageWriter::WriteRows(const unsigned char* rows, int count)
+{
+	if (!m_file || count < 0 || m_rowsWritten + count > m_height)
+		return false;
+
+	const size_t rowBytes = static_cast<size_t>(m_width) * 3;
+	m_rowsWritten += count;
+
+	if (m_format == Format::PPM)
+	{
+		const size_t size = rowBytes * count;
+		return std::fwrite(rows, 1, size, m_file) == size;
+	}
+
+	// every row is prefixed by its filter type
+	std::vector<unsigned char> filtered;
+	filtered.reserve((rowBytes + 1) * count);
+	for (int row = 0; row < count; ++row)
+	{
+		filtered.push_back(0);
+		filtered.insert(filtered.end(), rows + row * rowBytes, rows + (row + 1) * rowBytes);
+	}
+	return WriteStoredBlocks(filtered.data(), filtered.size(), false);
+}
+
+bool ImageWriter::Close()
+{
+	if (!m_file)
+		return false;
+
+	bool result = m_rowsWritten == m_height;
+	if (m_format == Format::PNG)
+	{
+		// an empty final block ends the deflate stream, the Adler-32 of the raw data ends the zlib one
+		result = result && WriteStoredBlocks(nullptr, 0, true);
+		std::vector<unsigned char> checksum;
+		PutBigEndian(checksum, (m_adlerB << 16) | m_adlerA);
+		result = result && WriteChunk("IDAT", checksum.data(), checksum.size());
+		result = result && WriteChunk("IEND", nullptr, 0);
+	}
+
+	result = std::fclose(m_file) == 0 && result;
+	m_file = nullptr;
+	return result;
+}
+
+bool ImageWriter::IsSupported(const std::string& path)
+{
+	return HasExtension(path, ".ppm") || HasExtension(path, ".png");
+}
+
+bool ImageWriter::WriteChunk(const char* type, const unsigned char* data, size_t size)
+{
+	m_chunk.clear();
+	PutBigEndian(m_chunk, static_cast<uint32_t>(size));
+	m_chunk.insert(m_chunk.end(), type, type + 4);
+	if (size > 0)
+	{
+		m_chunk.insert(m_chunk.end(), data, data + size);
+	}
+
+	// the CRC covers the type and the data
+	const uint32_t crc = UpdateCRC(0xFFFFFFFFu, m_chunk.data() + 4, size + 4) ^ 0xFFFFFFFFu;
+	PutBigEndian(m_chunk, crc);
+	return std::fwrite(m_chunk.data(), 1, m_chunk.size(), m_file) == m_chunk.size();
+}
+
+bool ImageWriter::WriteStoredBlocks(const unsigned char* data, size_t size, bool final)
+{
+	std::vector<unsigned char> blocks;
+	blocks.reserve(size + (size / s_maxStoredBlock + 1) * 5);
+
+	size_t offset = 0;
+	do
+	{
+		const size_t length = std::min(size - offset, s_maxStoredBlock);
+		const bool last = final && offset + length == size;
+
+		// BFINAL, BTYPE 00 and the padding to the byte boundary, then LEN and NLEN in little endian
+		blocks.push_back(last ? 1 : 0);
+		blocks.push_back(static_cast<unsigned char>(length));
+		blocks.push_back(static_cast<unsigned char>(length >> 8));
+		blocks.push_back(static_cast<unsigned char>(~length));
+		blocks.push_back(static_cast<unsigned char>(~length >> 8));
+		blocks.insert(blocks.end(), data + offset, data + offset + length);
+
+		for (size_t i = offset; i < offset + length; ++i)
+		{
+			m_adlerA = (m_adlerA + data[i]) % s_adlerModulo;
+			m_adlerB = (m_adlerB + m_adlerA) % s_adlerModulo;
+		}
+		offset += length;
+	} while (offset < size);
+
+	return WriteChunk("IDAT", blocks.data(), blocks.size());
+}
+
+bool ImageWriter::HasExtension(const std::string& path, const char* extension)
+{
+	const std::string suffix(extension);
+	if (path.size() < suffix.size())
+		return false;
+
+	return std::equal(suffix.begin(), suffix.end(), path.end() - suffix.size(), [](char lhs, char rhs)
+	{
+		return std::tolower(static_cast<unsigned char>(lhs)) == std::tolower(static_cast<unsigned char>(rhs));
+	});
+}
+
+uint32_t ImageWriter::UpdateCRC(uint32_t crc, const unsigned char* data, size_t size)
+{
+	static const std::vector<uint32_t> table = []()
+	{
+		std::vector<uint32_t> values(256);
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			values[n] = c;
+		}
+		return values;
+	}();
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
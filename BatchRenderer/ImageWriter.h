@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes 8-bit RGB images row by row from the top one, so a frame never has to be in memory at once.
+// The format follows the extension: .ppm (binary P6) or .png (stored deflate blocks, no compression library).
+class ImageWriter
+{
+public:
+	ImageWriter();
+	~ImageWriter();
+
+	bool Open(const std::string& path, int width, int height);
+	// `rows` holds `count` rows of width * 3 bytes
+	bool WriteRows(const unsigned char* rows, int count);
+	// Fails when fewer rows than the height were written
+	bool Close();
+
+	static bool IsSupported(const std::string& path);
+	// case-insensitive, `extension` includes the dot
+	static bool HasExtension(const std::string& path, const char* extension);
+
+private:
+	enum class Format
+	{
+		PPM,
+		PNG,
+	};
+
+	bool WriteChunk(const char* type, const unsigned char* data, size_t size);
+	bool WriteStoredBlocks(const unsigned char* data, size_t size, bool final);
+
+	static uint32_t UpdateCRC(uint32_t crc, const unsigned char* data, size_t size);
+
+	std::FILE* m_file;
+	Format m_format;
+	int m_width;
+	int m_height;
+	int m_rowsWritten;
+
+	// zlib stream state of the PNG image data
+	uint32_t m_adlerA;
+	uint32_t m_adlerB;
+	std::vector<unsigned char> m_chunk;
+};
@@ -0,0 +1,393 @@
+// Golden-image regression check of the CPU kernel variants: renders a fixed set of views with every variant
+// and compares the value planes (smooth iterations in color mode, distances in the gray mode) with reference
+// planes, together with the render time of each variant so speed and correctness regressions show up together.
+// The SIMD kernels have to match the scalar ones bit for bit; the other engines compute the same image with
+// different arithmetic and may differ by `--tolerance` at up to `--max-mismatch` of the pixels.
+// The references are grayscale PFM files in Benchmarks/golden, written by --record: the scalar kernels, or double-double
+// for deep views. A missing reference fails the check, as does one with too few escaping pixels to compare.
+// Usage: GoldenImages [--references <dir>] [--record] [--view <name>] [--threads <n>] [--tolerance <value>] [--max-mismatch <percent>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Data/RenderConfig.h"
+#include "Graphics/MandelbrotCPURender.h"
+#include "Graphics/Palette.h"
+#include "Graphics/CPU/EscapeKernels.h"
+
+// set by the build to the references of the source tree
+#ifndef GOLDEN_REFERENCES_DIR
+#define GOLDEN_REFERENCES_DIR "golden"
+#endif
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct View
+	{
+		const char* name;
+		// decimal text, parsed to the deep position
+		const char* centerX;
+		const char* centerY;
+		double zoom;
+		int maxIterations;
+		// beyond the precision of double: only the deep engines render it, double-double gives the reference
+		bool deep;
+	};
+
+	// Changing a view invalidates the recorded references, add a new one instead
+	const View s_views[] =
+	{
+		{ "full-set", "-0.75", "0", 1.0, 1024, false },
+		{ "seahorse-valley", "-0.7453", "0.1127", 60.0, 1024, false },
+		{ "elephant-valley", "0.2925", "0.0149", 60.0, 1024, false },
+		{ "minibrot", "-1.7548776662", "0", 40.0, 2048, false },
+		// next to the Misiurewicz point i: every pixel escapes and the iterations change smoothly between neighbours,
+		// unlike dense spirals where the rounding of each engine moves whole escape bands
+		{ "deep-zoom", "0.000000000000000021370985143", "1.000000000000000007423819376", 1e16, 1024, true },
+	};
+
+	const math::vec2i s_size(320, 180);
+
+	// share of the reference pixels that have to escape, an interior-only plane passes any variant
+	const double s_minExteriorShare = 0.1;
+
+	struct Variant
+	{
+		const char* name;
+		CPUEngine engine;
+		// kernels of CPUEngine::STANDARD and CPUEngine::DOUBLE_DOUBLE
+		kernels::KernelISA isa;
+		bool bla;
+		bool marianiSilver;
+		// has to match the reference bit for bit
+		bool exact;
+	};
+
+	const Variant s_variants[] =
+	{
+		{ "scalar", CPUEngine::STANDARD, kernels::KernelISA::SCALAR, false, false, true },
+		{ "sse2", CPUEngine::STANDARD, kernels::KernelISA::SSE2, false, false, true },
+		{ "avx2", CPUEngine::STANDARD, kernels::KernelISA::AVX2, false, false, true },
+		{ "avx512", CPUEngine::STANDARD, kernels::KernelISA::AVX512, false, false, true },
+		{ "double-double", CPUEngine::DOUBLE_DOUBLE, kernels::KernelISA::SCALAR, false, false, false },
+		{ "double-double-sse2", CPUEngine::DOUBLE_DOUBLE, kernels::KernelISA::SSE2, false, false, false },
+		{ "double-double-avx2", CPUEngine::DOUBLE_DOUBLE, kernels::KernelISA::AVX2, false, false, false },
+		{ "double-double-avx512", CPUEngine::DOUBLE_DOUBLE, kernels::KernelISA::AVX512, false, false, false },
+		{ "perturbation", CPUEngine::PERTURBATION, kernels::KernelISA::SCALAR, false, false, false },
+		{ "perturbation-bla", CPUEngine::PERTURBATION, kernels::KernelISA::SCALAR, true, false, false },
+		// fills rectangles from their borders, a wrong fill shows up as whole areas of mismatches
+		{ "mariani-silver", CPUEngine::STANDARD, kernels::KernelISA::SCALAR, false, true, false },
+	};
+
+	struct Options
+	{
+		std::string references = GOLDEN_REFERENCES_DIR;
+		bool record = false;
+		// only the view of this name, empty - all of them
+		std::string view;
+		size_t threadCount = 0;
+		// largest per-pixel difference of the inexact variants, in iterations or in pixels of distance
+		double tolerance = 0.01;
+		// percentage of the pixels the inexact variants may differ by more than the tolerance
+		double maxMismatch = 1.0;
+	};
+
+	struct Comparison
+	{
+		size_t mismatches = 0;
+		// interior in one plane and exterior in the other
+		size_t flips = 0;
+		// pixels without a value in the variant
+		size_t missing = 0;
+		double maxDifference = 0.0;
+		double meanDifference = 0.0;
+	};
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--record")
+			{
+				options.record = true;
+				continue;
+			}
+
+			if (i + 1 >= argc)
+			{
+				std::fprintf(stderr, "Missing value of %s\n", arg.c_str());
+				return false;
+			}
+
+			if (arg == "--references")
+			{
+				options.references = argv[++i];
+			}
+			else if (arg == "--view")
+			{
+				options.view = argv[++i];
+			}
+			else if (arg == "--threads")
+			{
+				options.threadCount = static_cast<size_t>(std::max(std::atoi(argv[++i]), 1));
+			}
+			else if (arg == "--tolerance")
+			{
+				options.tolerance = std::max(std::atof(argv[++i]), 0.0);
+			}
+			else if (arg == "--max-mismatch")
+			{
+				options.maxMismatch = std::clamp(std::atof(argv[++i]), 0.0, 100.0);
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (!options.view.empty() && std::none_of(std::begin(s_views), std::end(s_views), [&](const View& view) { return options.view == view.name; }))
+		{
+			std::fprintf(stderr, "Unknown view %s\n", options.view.c_str());
+			return false;
+		}
+
+		if (options.threadCount == 0)
+		{
+			options.threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		return true;
+	}
+
+	// Same defaults as ToolsUI without the tile cache, every pixel is computed by the kernels
+	std::shared_ptr<RenderConfig> MakeConfig(const View& view, const Variant& variant, bool color)
+	{
+		math::deepfixed centerX, centerY;
+		math::deepfixed::fromString(view.centerX, centerX);
+		math::deepfixed::fromString(view.centerY, centerY);
+
+		auto config = std::make_shared<RenderConfig>();
+		// the render position is the negated center of the view
+		config->m_deepPosition = math::vec2<math::deepfixed>(-centerX, -centerY);
+		config->m_position = math::vec2d(config->m_deepPosition.x.toDouble(), config->m_deepPosition.y.toDouble());
+		config->m_zoom = view.zoom;
+		config->m_maxIterations = view.maxIterations;
+		config->m_threshold = 65535.0f;
+		config->m_windowSize = math::vec2f(static_cast<float>(s_size.x), static_cast<float>(s_size.y));
+		config->m_useCPU = true;
+		config->m_colorEnabled = color;
+		config->m_paletteOffset = OFFSET_COLOR;
+		config->m_tileSize = 64;
+		config->m_cpuEngine = variant.engine;
+		config->m_blaEnabled = variant.bla;
+		config->m_periodicityEnabled = true;
+		config->m_marianiSilverEnabled = variant.marianiSilver;
+		return config;
+	}
+
+	// Value plane of the view rendered by the variant, and the seconds from the config change to the finished frame
+	double Render(const View& view, const Variant& variant, bool color, size_t threadCount, std::vector<float>& outValues)
+	{
+		MandelbrotCPURender render(threadCount, kernels::GetKernelSet(variant.isa));
+		const std::shared_ptr<RenderConfig> config = MakeConfig(view, variant, color);
+		render.BindData(config);
+
+		const Clock::time_point start = Clock::now();
+		render.OnUpdate();
+		render.Wait();
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		const float* values = render.GetPixelValues();
+		outValues.assign(values, values + static_cast<size_t>(s_size.x) * s_size.y);
+		return seconds;
+	}
+
+	bool IsAvailable(const View& view, const Variant& variant)
+	{
+		// GetKernelSet falls back to scalar, which would only repeat the scalar variant
+		return (variant.engine != CPUEngine::STANDARD || !view.deep) && kernels::IsSupported(variant.isa);
+	}
+
+	// the scalar kernels, double-double for deep views
+	const Variant& GetReferenceVariant(const View& view)
+	{
+		return view.deep ? s_variants[4] : s_variants[0];
+	}
+
+	std::string GetReferencePath(const Options& options, const View& view, bool color)
+	{
+		return options.references + "/" + view.name + (color ? "-iterations" : "-distance") + ".pfm";
+	}
+
+	// Grayscale PFM: little-endian floats, rows from the bottom one like the value plane
+	bool WritePFM(const std::string& path, const std::vector<float>& values)
+	{
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		std::fprintf(file, "Pf\n%d %d\n-1.0\n", s_size.x, s_size.y);
+		const bool written = std::fwrite(values.data(), sizeof(float), values.size(), file) == values.size();
+		return std::fclose(file) == 0 && written;
+	}
+
+	bool ReadPFM(const std::string& path, std::vector<float>& outValues)
+	{
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+
+		char magic[3] = {};
+		int width = 0, height = 0;
+		double scale = 0.0;
+		const bool header = std::fscanf(file, "%2s %d %d %lf", magic, &width, &height, &scale) == 4 && std::fgetc(file) != EOF;
+		bool read = header && std::strcmp(magic, "Pf") == 0 && width == s_size.x && height == s_size.y && scale < 0.0;
+		if (read)
+		{
+			outValues.resize(static_cast<size_t>(width) * height);
+			read = std::fread(outValues.data(), sizeof(float), outValues.size(), file) == outValues.size();
+		}
+		std::fclose(file);
+		return read;
+	}
+
+	size_t CountExterior(const std::vector<float>& values)
+	{
+		return static_cast<size_t>(std::count_if(values.begin(), values.end(), [](float value) { return value > 0.0f; }));
+	}
+
+	Comparison Compare(const std::vector<float>& reference, const std::vector<float>& values, bool exact, double tolerance)
+	{
+		Comparison result;
+		double differenceSum = 0.0;
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			if (std::isnan(values[i]))
+			{
+				++result.missing;
+				++result.mismatches;
+				continue;
+			}
+
+			// exact variants compare bit patterns, so not even -0 passes for 0
+			const double difference = std::abs(static_cast<double>(values[i]) - reference[i]);
+			const bool match = exact ? std::memcmp(&reference[i], &values[i], sizeof(float)) == 0 : difference <= tolerance;
+			result.flips += (values[i] == 0.0f) != (reference[i] == 0.0f) ? 1 : 0;
+			result.mismatches += match ? 0 : 1;
+			result.maxDifference = std::max(result.maxDifference, difference);
+			differenceSum += difference;
+		}
+		result.meanDifference = values.empty() ? 0.0 : differenceSum / values.size();
+		return result;
+	}
+
+	void PrintRow(const View& view, const char* mode, const Variant& variant, double seconds, const Comparison& comparison, bool passed)
+	{
+		const double pixels = static_cast<double>(s_size.x) * s_size.y;
+		std::printf("%-16s %-10s %-20s %9.2f %8.2f %9zu %7.3f%% %6zu %11.4g %11.4g  %s\n",
+			view.name, mode, variant.name, seconds * 1e3, pixels / seconds * 1e-6, comparison.mismatches,
+			100.0 * comparison.mismatches / pixels, comparison.flips, comparison.maxDifference, comparison.meanDifference, passed ? "ok" : "FAIL");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::fprintf(stderr, "Usage: GoldenImages [--references <dir>] [--record] [--view <name>] [--threads <n>] [--tolerance <value>] [--max-mismatch <percent>]\n");
+		return 1;
+	}
+
+	const double pixels = static_cast<double>(s_size.x) * s_size.y;
+	if (options.record)
+	{
+		for (const View& view : s_views)
+		{
+			if (!options.view.empty() && options.view != view.name)
+				continue;
+
+			for (bool color : { true, false })
+			{
+				std::vector<float> values;
+				const double seconds = Render(view, GetReferenceVariant(view), color, options.threadCount, values);
+				const std::string path = GetReferencePath(options, view, color);
+				if (CountExterior(values) < s_minExteriorShare * pixels)
+				{
+					std::fprintf(stderr, "%s: only %zu escaping pixels, the view is not worth a reference\n", path.c_str(), CountExterior(values));
+					return 1;
+				}
+				if (!WritePFM(path, values))
+				{
+					std::fprintf(stderr, "Failed to write %s\n", path.c_str());
+					return 1;
+				}
+				std::printf("%s: %s, %.2f ms\n", path.c_str(), GetReferenceVariant(view).name, seconds * 1e3);
+			}
+		}
+		return 0;
+	}
+
+	std::printf("%dx%d, %zu threads, tolerance %g, at most %g%% mismatches for inexact variants\n",
+		s_size.x, s_size.y, options.threadCount, options.tolerance, options.maxMismatch);
+	std::printf("%-16s %-10s %-20s %9s %8s %9s %8s %6s %11s %11s\n", "view", "mode", "variant", "ms", "Mpix/s", "mismatch", "", "flips", "max diff", "mean diff");
+
+	size_t failures = 0;
+	for (const View& view : s_views)
+	{
+		if (!options.view.empty() && options.view != view.name)
+			continue;
+
+		for (bool color : { true, false })
+		{
+			const char* mode = color ? "iterations" : "distance";
+			const std::string path = GetReferencePath(options, view, color);
+			std::vector<float> reference;
+			if (!ReadPFM(path, reference))
+			{
+				std::printf("%-16s %-10s no reference %s  FAIL\n", view.name, mode, path.c_str());
+				++failures;
+				continue;
+			}
+			if (CountExterior(reference) < s_minExteriorShare * pixels)
+			{
+				std::printf("%-16s %-10s only %zu escaping pixels in %s  FAIL\n", view.name, mode, CountExterior(reference), path.c_str());
+				++failures;
+				continue;
+			}
+
+			for (const Variant& variant : s_variants)
+			{
+				if (!IsAvailable(view, variant))
+					continue;
+
+				std::vector<float> values;
+				const double seconds = Render(view, variant, color, options.threadCount, values);
+				const Comparison comparison = Compare(reference, values, variant.exact, options.tolerance);
+				const bool passed = variant.exact ? comparison.mismatches == 0
+					: comparison.missing == 0 && 100.0 * comparison.mismatches / pixels <= options.maxMismatch;
+				failures += passed ? 0 : 1;
+				PrintRow(view, mode, variant, seconds, comparison, passed);
+			}
+		}
+	}
+
+	if (failures > 0)
+	{
+		std::printf("%zu checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
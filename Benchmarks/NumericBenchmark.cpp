@@ -0,0 +1,154 @@
+// Throughput of the numeric types used by the CPU kernels, compared against plain double.
+// Usage: NumericBenchmark [seconds per case]
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Math/vec.h"
+#include "Math/floatexp.h"
+#include "Math/fixedpoint.h"
+#include "Graphics/CPU/ReferenceOrbit.h"
+#include "Graphics/CPU/BLATable.h"
+#include "Graphics/CPU/PerturbationKernels.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// keeps results alive without letting the compiler fold the loops
+	volatile double s_sink = 0.0;
+
+	template<class Func>
+	double MeasureRate(double seconds, Func&& func)
+	{
+		// returns work units per second, `func` runs one batch and returns its unit count
+		double units = 0.0;
+		const Clock::time_point start = Clock::now();
+		double elapsed = 0.0;
+		do
+		{
+			units += func();
+			elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (elapsed < seconds);
+		return units / elapsed;
+	}
+
+	// Z -> Z^2 + c on a batch of independent points, counts iterations
+	template<class Real>
+	double QuadraticIterations(const std::vector<math::vec2<Real>>& points, int iterations)
+	{
+		double sum = 0.0;
+		for (const math::vec2<Real>& c : points)
+		{
+			math::vec2<Real> z;
+			for (int i = 0; i < iterations; ++i)
+			{
+				z = math::vec2<Real>(z.x * z.x - z.y * z.y + c.x, 2.0 * z.x * z.y + c.y);
+			}
+			sum += math::toDouble(math::dot(z, z));
+		}
+		s_sink = sum;
+		return static_cast<double>(points.size()) * iterations;
+	}
+
+	template<class Real>
+	double DotProducts(const std::vector<math::vec2<Real>>& points, int repeats)
+	{
+		Real sum = 0.0;
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (const math::vec2<Real>& p : points)
+			{
+				sum += math::dot(p, p);
+			}
+		}
+		s_sink = math::toDouble(sum);
+		return static_cast<double>(points.size()) * repeats;
+	}
+
+	template<class Real>
+	std::vector<math::vec2<Real>> MakePoints(size_t count)
+	{
+		// points on a segment inside the main cardioid, their orbits stay bounded
+		std::vector<math::vec2<Real>> points;
+		points.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const double t = static_cast<double>(i) / count;
+			points.emplace_back(-0.1 + 0.2 * t, 0.1 - 0.15 * t);
+		}
+		return points;
+	}
+
+	template<class Real>
+	double PerturbationIterations(const ReferenceOrbit& orbit, const std::vector<Real>& dcx, const std::vector<Real>& dcy, int maxIterations, std::vector<double>& out)
+	{
+		// perturbation kernels ignore periodicity, the tolerance stays off
+		const kernels::EscapeParams params = { 65535.0, std::log(65535.0), maxIterations, 0.0 };
+		kernels::EscapeStats stats;
+		kernels::SmoothIterationsPerturbation(params, orbit, nullptr, dcx.data(), dcy.data(), dcx.size(), out.data(), stats);
+		return static_cast<double>(stats.iterations);
+	}
+
+	void PrintRow(const char* name, double doubleRate, double floatexpRate, const char* unit)
+	{
+		std::printf("%-28s %12.1f %12.1f %9.2fx   %s\n", name, doubleRate / 1e6, floatexpRate / 1e6, doubleRate / floatexpRate, unit);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const double seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+
+	std::printf("%-28s %12s %12s %10s\n", "case", "double M/s", "floatexp M/s", "slowdown");
+
+	{
+		const std::vector<math::vec2d> points = MakePoints<double>(256);
+		const std::vector<math::vec2<math::floatexp>> wide = MakePoints<math::floatexp>(256);
+		const double doubleRate = MeasureRate(seconds, [&]() { return QuadraticIterations(points, 1000); });
+		const double floatexpRate = MeasureRate(seconds, [&]() { return QuadraticIterations(wide, 1000); });
+		PrintRow("z^2 + c", doubleRate, floatexpRate, "iterations");
+	}
+
+	{
+		const std::vector<math::vec2d> points = MakePoints<double>(4096);
+		const std::vector<math::vec2<math::floatexp>> wide = MakePoints<math::floatexp>(4096);
+		const double doubleRate = MeasureRate(seconds, [&]() { return DotProducts(points, 64); });
+		const double floatexpRate = MeasureRate(seconds, [&]() { return DotProducts(wide, 64); });
+		PrintRow("dot", doubleRate, floatexpRate, "products");
+	}
+
+	{
+		// seahorse valley at 1e25, deltas on a 32x32 grid over the view
+		const double zoom = 1e25;
+		const int maxIterations = 5000;
+		math::vec2<math::deepfixed> center;
+		math::deepfixed::fromString("-0.743643887037158704752191506114774", center.x);
+		math::deepfixed::fromString("0.131825904205311970493132056385139", center.y);
+
+		std::atomic<bool> cancel(false);
+		ReferenceOrbit orbit;
+		orbit.Compute(center, zoom, 200, maxIterations, 65535.0, cancel);
+
+		const size_t count = 1024;
+		std::vector<double> dcx(count), dcy(count), out(count);
+		std::vector<math::floatexp> wideX(count), wideY(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			dcx[i] = (static_cast<double>(i % 32) / 16.0 - 1.0) * 1.6 / zoom;
+			dcy[i] = (static_cast<double>(i / 32) / 16.0 - 1.0) / zoom;
+			wideX[i] = dcx[i];
+			wideY[i] = dcy[i];
+		}
+
+		const double doubleRate = MeasureRate(seconds, [&]() { return PerturbationIterations(orbit, dcx, dcy, maxIterations, out); });
+		const double floatexpRate = MeasureRate(seconds, [&]() { return PerturbationIterations(orbit, wideX, wideY, maxIterations, out); });
+		PrintRow("perturbation (1e25)", doubleRate, floatexpRate, "iterations");
+	}
+
+	return 0;
+}
@@ -0,0 +1,305 @@
+// Throughput of the CPU renderer on a fixed catalogue of views, at several sizes, iteration limits and thread counts.
+// Every run renders with a fresh renderer, so no pixel comes from a previous frame or the tile cache.
+// Usage: RenderBenchmark [--quick] [--repeats <n>] [--threads <n,n,...>] [--json <file>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Data/RenderConfig.h"
+#include "Graphics/MandelbrotCPURender.h"
+#include "Graphics/Palette.h"
+#include "Graphics/CPU/EscapeKernels.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct View
+	{
+		const char* name;
+		// decimal text, parsed to the deep position
+		const char* centerX;
+		const char* centerY;
+		double zoom;
+		CPUEngine engine;
+		std::vector<int> maxIterations;
+	};
+
+	// Changing a view breaks the comparison with earlier runs, add a new one instead
+	const View s_views[] =
+	{
+		{ "full-set", "-0.75", "0", 0.9, CPUEngine::STANDARD, { 256, 1024, 4096 } },
+		{ "seahorse-valley", "-0.7453", "0.1127", 60.0, CPUEngine::STANDARD, { 256, 1024, 4096 } },
+		{ "elephant-valley", "0.2925", "0.0149", 60.0, CPUEngine::STANDARD, { 256, 1024, 4096 } },
+		{ "minibrot", "-1.7548776662", "0", 40.0, CPUEngine::STANDARD, { 256, 1024, 4096 } },
+		{ "deep-zoom", "-0.743643887037158704752191506114774", "0.131825904205311970493132056385139", 1e25, CPUEngine::PERTURBATION, { 20000, 50000 } },
+	};
+
+	const math::vec2i s_sizes[] = { math::vec2i(640, 360), math::vec2i(1280, 720), math::vec2i(1920, 1080) };
+
+	struct Options
+	{
+		// first size and iteration limit of every view only
+		bool quick = false;
+		int repeats = 3;
+		std::vector<size_t> threadCounts;
+		std::string json;
+	};
+
+	struct Run
+	{
+		size_t threadCount;
+		// median over the repeats
+		double seconds;
+	};
+
+	struct Case
+	{
+		const View* view;
+		math::vec2i size;
+		int maxIterations;
+		size_t iterations;
+		std::vector<Run> runs;
+	};
+
+	const char* GetEngineName(CPUEngine engine)
+	{
+		switch (engine)
+		{
+		case CPUEngine::PERTURBATION:
+			return "perturbation";
+		case CPUEngine::DOUBLE_DOUBLE:
+			return "double-double";
+		default:
+			return "standard";
+		}
+	}
+
+	// 1, 2, 4, ... up to all hardware threads
+	std::vector<size_t> GetDefaultThreadCounts()
+	{
+		const size_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		std::vector<size_t> counts;
+		for (size_t count = 1; count < hardwareThreads; count *= 2)
+		{
+			counts.push_back(count);
+		}
+		counts.push_back(hardwareThreads);
+		return counts;
+	}
+
+	bool ParseThreadCounts(const std::string& text, std::vector<size_t>& outCounts)
+	{
+		outCounts.clear();
+		size_t start = 0;
+		while (start <= text.size())
+		{
+			const size_t end = std::min(text.find(',', start), text.size());
+			const int count = std::atoi(text.substr(start, end - start).c_str());
+			if (count <= 0)
+				return false;
+			outCounts.push_back(static_cast<size_t>(count));
+			start = end + 1;
+		}
+		return !outCounts.empty();
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--quick")
+			{
+				options.quick = true;
+				continue;
+			}
+
+			if (i + 1 >= argc)
+			{
+				std::fprintf(stderr, "Missing value of %s\n", arg.c_str());
+				return false;
+			}
+
+			if (arg == "--repeats")
+			{
+				options.repeats = std::max(std::atoi(argv[++i]), 1);
+			}
+			else if (arg == "--threads")
+			{
+				if (!ParseThreadCounts(argv[++i], options.threadCounts))
+				{
+					std::fprintf(stderr, "Threads have to be a list of positive counts, e.g. 1,4,16\n");
+					return false;
+				}
+			}
+			else if (arg == "--json")
+			{
+				options.json = argv[++i];
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (options.threadCounts.empty())
+		{
+			options.threadCounts = GetDefaultThreadCounts();
+		}
+		return true;
+	}
+
+	// Same defaults as ToolsUI without the tile cache, the view comes from the catalogue
+	std::shared_ptr<RenderConfig> MakeConfig(const View& view, const math::vec2i& size, int maxIterations)
+	{
+		math::deepfixed centerX, centerY;
+		math::deepfixed::fromString(view.centerX, centerX);
+		math::deepfixed::fromString(view.centerY, centerY);
+
+		auto config = std::make_shared<RenderConfig>();
+		// the render position is the negated center of the view
+		config->m_deepPosition = math::vec2<math::deepfixed>(-centerX, -centerY);
+		config->m_position = math::vec2d(config->m_deepPosition.x.toDouble(), config->m_deepPosition.y.toDouble());
+		config->m_zoom = view.zoom;
+		config->m_maxIterations = maxIterations;
+		config->m_threshold = 65535.0f;
+		config->m_windowSize = math::vec2f(static_cast<float>(size.x), static_cast<float>(size.y));
+		config->m_useCPU = true;
+		config->m_colorEnabled = true;
+		config->m_paletteOffset = OFFSET_COLOR;
+		config->m_tileSize = 64;
+		config->m_cpuEngine = view.engine;
+		config->m_blaEnabled = true;
+		config->m_periodicityEnabled = true;
+		return config;
+	}
+
+	// Seconds from the config change to the finished frame, the reference orbit of deep views included
+	double MeasureRender(const std::shared_ptr<RenderConfig>& config, size_t threadCount, size_t& outIterations)
+	{
+		MandelbrotCPURender render(threadCount);
+		render.BindData(config);
+
+		const Clock::time_point start = Clock::now();
+		render.OnUpdate();
+		render.Wait();
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		outIterations = render.GetKernelStats().iterations;
+		return seconds;
+	}
+
+	Case RunCase(const View& view, const math::vec2i& size, int maxIterations, const Options& options)
+	{
+		Case result = { &view, size, maxIterations, 0, {} };
+		const std::shared_ptr<RenderConfig> config = MakeConfig(view, size, maxIterations);
+		for (size_t threadCount : options.threadCounts)
+		{
+			std::vector<double> seconds;
+			for (int repeat = 0; repeat < options.repeats; ++repeat)
+			{
+				seconds.push_back(MeasureRender(config, threadCount, result.iterations));
+			}
+			std::sort(seconds.begin(), seconds.end());
+			result.runs.push_back({ threadCount, seconds[seconds.size() / 2] });
+		}
+		return result;
+	}
+
+	double GetPixels(const Case& result)
+	{
+		return static_cast<double>(result.size.x) * result.size.y;
+	}
+
+	// scaling against the first thread count of the case
+	double GetSpeedup(const Case& result, const Run& run)
+	{
+		return result.runs.front().seconds / run.seconds;
+	}
+
+	double GetEfficiency(const Case& result, const Run& run)
+	{
+		return GetSpeedup(result, run) * result.runs.front().threadCount / run.threadCount;
+	}
+
+	void PrintCase(const Case& result)
+	{
+		for (const Run& run : result.runs)
+		{
+			std::printf("%-16s %5dx%-5d %7d %8zu %10.2f %10.2f %10.3f %8.2fx %7.1f%%\n",
+				result.view->name, result.size.x, result.size.y, result.maxIterations, run.threadCount, run.seconds * 1e3,
+				GetPixels(result) / run.seconds * 1e-6, result.iterations / run.seconds * 1e-9,
+				GetSpeedup(result, run), GetEfficiency(result, run) * 100.0);
+		}
+	}
+
+	bool WriteJson(const std::string& path, const Options& options, const std::vector<Case>& cases)
+	{
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (!file)
+			return false;
+
+		std::fprintf(file, "{\n  \"kernels\": \"%s\",\n  \"hardwareThreads\": %u,\n  \"repeats\": %d,\n  \"cases\": [\n",
+			kernels::SelectKernelSet().name, std::thread::hardware_concurrency(), options.repeats);
+		for (size_t i = 0; i < cases.size(); ++i)
+		{
+			const Case& result = cases[i];
+			std::fprintf(file, "    {\n      \"view\": \"%s\",\n      \"engine\": \"%s\",\n      \"width\": %d,\n      \"height\": %d,\n"
+				"      \"maxIterations\": %d,\n      \"iterations\": %zu,\n      \"runs\": [\n",
+				result.view->name, GetEngineName(result.view->engine), result.size.x, result.size.y, result.maxIterations, result.iterations);
+			for (size_t j = 0; j < result.runs.size(); ++j)
+			{
+				const Run& run = result.runs[j];
+				std::fprintf(file, "        { \"threads\": %zu, \"seconds\": %.6f, \"mpixPerSecond\": %.3f, \"iterationsPerSecond\": %.6g, \"speedup\": %.3f, \"efficiency\": %.3f }%s\n",
+					run.threadCount, run.seconds, GetPixels(result) / run.seconds * 1e-6, result.iterations / run.seconds,
+					GetSpeedup(result, run), GetEfficiency(result, run), j + 1 < result.runs.size() ? "," : "");
+			}
+			std::fprintf(file, "      ]\n    }%s\n", i + 1 < cases.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n}\n");
+		return std::fclose(file) == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::fprintf(stderr, "Usage: RenderBenchmark [--quick] [--repeats <n>] [--threads <n,n,...>] [--json <file>]\n");
+		return 1;
+	}
+
+	std::printf("kernels %s, %u hardware threads, median of %d runs\n", kernels::SelectKernelSet().name, std::thread::hardware_concurrency(), options.repeats);
+	std::printf("%-16s %11s %7s %8s %10s %10s %10s %9s %8s\n", "view", "size", "iter", "threads", "ms", "Mpix/s", "Giter/s", "speedup", "eff");
+
+	std::vector<Case> cases;
+	for (const View& view : s_views)
+	{
+		const size_t sizeCount = options.quick ? 1 : std::size(s_sizes);
+		const size_t limitCount = options.quick ? 1 : view.maxIterations.size();
+		for (size_t size = 0; size < sizeCount; ++size)
+		{
+			for (size_t limit = 0; limit < limitCount; ++limit)
+			{
+				cases.push_back(RunCase(view, s_sizes[size], view.maxIterations[limit], options));
+				PrintCase(cases.back());
+			}
+		}
+	}
+
+	if (!options.json.empty() && !WriteJson(options.json, options, cases))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", options.json.c_str());
+		return 1;
+	}
+	return 0;
+}
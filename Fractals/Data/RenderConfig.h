@@ -1,12 +1,20 @@
 #pragma once
 
 #include "Math/vec.h"
+#include "Math/fixedpoint.h"
+
+enum class CPUEngine
+{
+	STANDARD,
+	PERTURBATION,
+	DOUBLE_DOUBLE,
+};
 
 struct RenderConfig
 {
 	bool m_useCPU;
 
-	float m_zoom;
+	double m_zoom;
 	float m_threshold;
 	int m_maxIterations;
 
@@ -14,9 +22,43 @@ struct RenderConfig
 	math::vec2d m_position;
 	math::vec2d m_offset;
 
+	// m_position with enough precision for deep zooms, used by CPUEngine::PERTURBATION and CPUEngine::DOUBLE_DOUBLE
+	math::vec2<math::deepfixed> m_deepPosition;
+
 	bool m_colorEnabled;
 
-	RenderConfig() : m_zoom(0), m_threshold(0), m_maxIterations(0), m_colorEnabled(false), m_useCPU(false){}
+	// palette entries added to the smooth iteration count before the lookup, only changes the presentation
+	float m_paletteOffset;
+
+	// CPU work unit edge in pixels, 0 - interleaved rows
+	int m_tileSize;
+
+	CPUEngine m_cpuEngine;
+
+	// skip iterations with the bilinear approximation of the reference orbit, used by CPUEngine::PERTURBATION
+	bool m_blaEnabled;
+
+	// stop interior points caught in an attracting cycle, not used by CPUEngine::PERTURBATION
+	bool m_periodicityEnabled;
+
+	// trace tile borders and fill the tiles whose border agrees, subdividing the others
+	bool m_marianiSilverEnabled;
+
+	// render every 8th pixel first and refine in 4/2/1 passes, takes precedence over m_marianiSilverEnabled
+	bool m_progressiveEnabled;
+
+	// memory cap of the CPUEngine::STANDARD tile cache in megabytes, 0 - disabled
+	int m_tileCacheSize;
+
+	// CPU only: rows map to the logarithm of the distance from the center and columns to the angle around it,
+	// the frame covers the ring from 1 / (2 * m_zoom) to 1 / m_zoom - one octave of an exponential map zoom video
+	bool m_exponentialMap;
+
+	// CPU only: jittered sub-samples added at most to a pixel whose value differs sharply from a neighbour,
+	// averaged with the pixel point after the frame is complete; 0 - no supersampling pass
+	int m_maxSubsamples;
+
+	RenderConfig() : m_useCPU(false), m_zoom(0), m_threshold(0), m_maxIterations(0), m_colorEnabled(false), m_paletteOffset(0), m_tileSize(0), m_cpuEngine(CPUEngine::STANDARD), m_blaEnabled(false), m_periodicityEnabled(false), m_marianiSilverEnabled(false), m_progressiveEnabled(false), m_tileCacheSize(0), m_exponentialMap(false), m_maxSubsamples(0){}
 
 	bool operator==(const RenderConfig& rhs) const
 	{
@@ -26,8 +68,19 @@ struct RenderConfig
 			&& m_windowSize == rhs.m_windowSize
 			&& m_position == rhs.m_position
 			&& m_offset == rhs.m_offset
+			&& m_deepPosition == rhs.m_deepPosition
 			&& m_useCPU == rhs.m_useCPU
-			&& m_colorEnabled == rhs.m_colorEnabled;
+			&& m_colorEnabled == rhs.m_colorEnabled
+			&& m_paletteOffset == rhs.m_paletteOffset
+			&& m_tileSize == rhs.m_tileSize
+			&& m_cpuEngine == rhs.m_cpuEngine
+			&& m_blaEnabled == rhs.m_blaEnabled
+			&& m_periodicityEnabled == rhs.m_periodicityEnabled
+			&& m_marianiSilverEnabled == rhs.m_marianiSilverEnabled
+			&& m_progressiveEnabled == rhs.m_progressiveEnabled
+			&& m_tileCacheSize == rhs.m_tileCacheSize
+			&& m_exponentialMap == rhs.m_exponentialMap
+			&& m_maxSubsamples == rhs.m_maxSubsamples;
 	}
 
 	bool operator!=(const RenderConfig& rhs) const
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "Math/vec.h"
+
+// Counters and timings of the last CPU render job, also read while the job runs
+struct RenderStats
+{
+	math::vec2i m_resolution;
+
+	// Z -> Z^2 + c steps of the computed pixels and sub-samples, iterations skipped by BLA steps included
+	size_t m_iterations;
+	// pixels inside M1/M2, rejected by the bulb test without a single step
+	size_t m_bulbPixels;
+	// pixels still bounded after maxIterations
+	size_t m_maxIterationPixels;
+	// interior pixels stopped by periodicity detection before maxIterations
+	size_t m_periodicPixels;
+	// pixels given sub-samples by the supersampling pass, and the sub-samples added to them
+	size_t m_refinedPixels;
+	size_t m_subsamples;
+	// tile cache lookups of the job and the pixels filled by the hits, all 0 without the cache
+	size_t m_cacheHits;
+	size_t m_cacheMisses;
+	size_t m_cachedPixels;
+	// tiles held by the cache and their memory in bytes
+	size_t m_cacheTiles;
+	size_t m_cacheBytes;
+
+	// drawing time of each worker in ms, waiting for the reference orbit or for tiles excluded
+	std::vector<double> m_workerBusyTimes;
+
+	// ms from the job start until the first tile was drawn, negative before
+	double m_firstPixelTime;
+	// ms from the job start until the last worker finished, the time so far while the job runs
+	double m_elapsedTime;
+	bool m_finished;
+
+	RenderStats() : m_iterations(0), m_bulbPixels(0), m_maxIterationPixels(0), m_periodicPixels(0), m_refinedPixels(0), m_subsamples(0), m_cacheHits(0), m_cacheMisses(0), m_cachedPixels(0), m_cacheTiles(0), m_cacheBytes(0), m_firstPixelTime(-1.0), m_elapsedTime(0.0), m_finished(false){}
+
+	// frame pixels per second of the finished job in millions, 0 while it runs
+	double GetMegapixelsPerSecond() const
+	{
+		if (!m_finished || m_elapsedTime <= 0.0)
+			return 0.0;
+		return static_cast<double>(m_resolution.x) * m_resolution.y / (m_elapsedTime * 1e3);
+	}
+};
@@ -0,0 +1,47 @@
+# The CPU engine as a static library, shared by the application, BatchRenderer and the benchmarks.
+# Each of them can be configured on its own, so every one includes this file and the first one defines the target.
+if(TARGET FractalsCPU)
+	return()
+endif()
+
+set(FRACTALS_CPU_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+find_package( Threads REQUIRED )
+
+set(FRACTALS_CPU_SRCS
+	${FRACTALS_CPU_DIR}/Graphics/MandelbrotCPURender.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernels.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsSSE2.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsAVX2.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsAVX512.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsDoubleDouble.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/PerturbationKernels.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/ReferenceOrbit.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/BLATable.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/TileScheduler.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/TileCache.cpp
+	${FRACTALS_CPU_DIR}/Graphics/CPU/MappedFile.cpp
+	${FRACTALS_CPU_DIR}/Threading/ThreadPool.cpp
+	${FRACTALS_CPU_DIR}/Logger/Logger.cpp
+	${FRACTALS_CPU_DIR}/Logger/ConsoleLogger.cpp
+	${FRACTALS_CPU_DIR}/Trace/Trace.cpp
+)
+
+add_library (FractalsCPU STATIC ${FRACTALS_CPU_SRCS})
+target_include_directories(FractalsCPU PUBLIC ${FRACTALS_CPU_DIR})
+target_link_libraries(FractalsCPU PUBLIC Threads::Threads)
+
+if(MSVC)
+	target_compile_definitions(FractalsCPU PRIVATE _CRT_SECURE_NO_WARNINGS)
+	set_property(TARGET FractalsCPU PROPERTY MSVC_RUNTIME_LIBRARY "MultiThreaded$<$<CONFIG:Debug>:Debug>")
+endif()
+
+# SIMD escape-time kernels are built for their own instruction set and picked at runtime
+if(NOT MSVC)
+	set_source_files_properties(${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsSSE2.cpp PROPERTIES COMPILE_OPTIONS "-msse2;-ffp-contract=off")
+	set_source_files_properties(${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsAVX2.cpp PROPERTIES COMPILE_OPTIONS "-mavx2;-ffp-contract=off")
+	set_source_files_properties(${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsAVX512.cpp PROPERTIES COMPILE_OPTIONS "-mavx512f;-ffp-contract=off")
+	set_source_files_properties(${FRACTALS_CPU_DIR}/Graphics/CPU/EscapeKernelsDoubleDouble.cpp PROPERTIES COMPILE_OPTIONS "-ffp-contract=off")
+endif()
+
+set_property(TARGET FractalsCPU PROPERTY CXX_STANDARD 20)
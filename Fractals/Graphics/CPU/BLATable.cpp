@@ -0,0 +1,131 @@
+#include "BLATable.h"
+
+#include <cmath>
+#include <bit>
+#include <algorithm>
+
+#include "ReferenceOrbit.h"
+
+const double BLATable::s_epsilon = std::ldexp(1.0, -40);
+
+namespace
+{
+	math::vec2d ComplexMul(const math::vec2d& a, const math::vec2d& b)
+	{
+		return math::vec2d(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+	}
+
+	double Magnitude(const math::vec2d& a)
+	{
+		return std::sqrt(math::dot(a, a));
+	}
+
+	// `x` followed by `y`: dz -> Ay*(Ax*dz + Bx*dc) + By*dc
+	BLAStep Merge(const BLAStep& x, const BLAStep& y, double maxDelta)
+	{
+		BLAStep step;
+		step.A = ComplexMul(y.A, x.A);
+		step.B = ComplexMul(y.A, x.B) + y.B;
+		step.length = x.length + y.length;
+
+		// dz after `x` must stay inside the radius of `y`
+		const double radiusY = std::max(0.0, (y.radius - Magnitude(x.B) * maxDelta) / Magnitude(x.A));
+		step.radius = std::min(x.radius, radiusY);
+		return step;
+	}
+}
+
+BLATable::BLATable()
+	: m_maxDeltaNorm(0.0)
+	, m_maxDelta(0.0)
+{
+}
+
+void BLATable::Build(const ReferenceOrbit& orbit, double maxDelta)
+{
+	Clear();
+	m_maxDelta = maxDelta;
+
+	const math::vec2d* Z = orbit.GetPoints();
+	const size_t length = orbit.GetLength();
+	if (length < 3)
+		return;
+
+	// single steps from Z_n, n = 1 .. length - 2: dz -> 2*Z*dz + dc while dz^2 is negligible.
+	// No step lands on the last point, so an escape of the reference is always iterated per pixel.
+	std::vector<BLAStep> level(length - 2);
+	for (size_t n = 1; n + 1 < length; ++n)
+	{
+		BLAStep& step = level[n - 1];
+		step.A = 2.0 * Z[n];
+		step.B = math::vec2d(1.0, 0.0);
+		step.radius = s_epsilon * std::max(0.0, Magnitude(Z[n]) - maxDelta);
+		step.length = 1;
+	}
+	m_levels.push_back(std::move(level));
+
+	while (m_levels.back().size() > 1)
+	{
+		const std::vector<BLAStep>& previous = m_levels.back();
+		std::vector<BLAStep> merged((previous.size() + 1) / 2);
+		for (size_t i = 0; i < merged.size(); ++i)
+		{
+			const size_t first = 2 * i;
+			merged[i] = first + 1 < previous.size() ? Merge(previous[first], previous[first + 1], maxDelta) : previous[first];
+		}
+		m_levels.push_back(std::move(merged));
+	}
+
+	// level 1 holds the shortest steps Lookup returns, their radii bound all longer ones
+	if (m_levels.size() > 1)
+	{
+		for (const BLAStep& step : m_levels[1])
+		{
+			m_maxDeltaNorm = std::max(m_maxDeltaNorm, step.radius * step.radius);
+		}
+	}
+}
+
+void BLATable::Clear()
+{
+	m_levels.clear();
+	m_maxDeltaNorm = 0.0;
+	m_maxDelta = 0.0;
+}
+
+const BLAStep* BLATable::Lookup(size_t n, double deltaNorm) const
+{
+	if (n == 0 || m_levels.empty() || n > m_levels[0].size())
+		return nullptr;
+
+	// a step of level k starts at every 2^k-th reference index
+	const size_t index = n - 1;
+	const size_t topLevel = index == 0 ? m_levels.size() - 1 : std::min<size_t>(std::countr_zero(index), m_levels.size() - 1);
+
+	// radii shrink with the level, so climb while the next level is still valid
+	const BLAStep* result = nullptr;
+	for (size_t k = 1; k <= topLevel; ++k)
+	{
+		const BLAStep& step = m_levels[k][index >> k];
+		if (deltaNorm >= step.radius * step.radius)
+			break;
+
+		result = &step;
+	}
+	return result;
+}
+
+double BLATable::GetMaxDeltaNorm() const
+{
+	return m_maxDeltaNorm;
+}
+
+double BLATable::GetMaxDelta() const
+{
+	return m_maxDelta;
+}
+
+size_t BLATable::GetLevelCount() const
+{
+	return m_levels.size();
+}
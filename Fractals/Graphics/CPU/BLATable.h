@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "Math/vec.h"
+
+class ReferenceOrbit;
+
+// Bilinear approximation of the reference orbit: `length` perturbation steps starting at Z_n are
+// replaced by dz -> A*dz + B*dc, which holds while |dz| < radius.
+struct BLAStep
+{
+	math::vec2d A;
+	math::vec2d B;
+	double radius;
+	int length;
+};
+
+// Merged BLA steps over the reference orbit, level k holds steps of 2^k iterations.
+// Steps are only valid for pixels with |dc| <= the `maxDelta` the table was built for.
+//
+// Tolerance: every single step drops a dz^2 term below s_epsilon (2^-40) relative to |Z|*|dz|.
+// Smooth iteration counts stay within 1e-3 of the per-pixel perturbation loop, except for pixels
+// whose orbits amplify rounding errors (dense filaments, ~2% of a frame in seahorse valley at 1e18..1e25),
+// which may differ by whole iterations - the same pixels where double and exact arithmetic disagree.
+class BLATable
+{
+public:
+	BLATable();
+
+	void Build(const ReferenceOrbit& orbit, double maxDelta);
+	void Clear();
+
+	// Longest valid step at reference index `n` for a delta with |dz|^2 = `deltaNorm`, nullptr if none skips anything
+	const BLAStep* Lookup(size_t n, double deltaNorm) const;
+
+	// Lookup never succeeds for deltas with |dz|^2 >= this value, lets callers skip it cheaply
+	double GetMaxDeltaNorm() const;
+	// `maxDelta` of the last Build, the table also holds for any smaller one
+	double GetMaxDelta() const;
+
+	size_t GetLevelCount() const;
+
+private:
+	std::vector<std::vector<BLAStep>> m_levels;
+	double m_maxDeltaNorm;
+	double m_maxDelta;
+
+	static const double s_epsilon;
+};
@@ -0,0 +1,141 @@
+#include "EscapeKernels.h"
+
+#include <cmath>
+
+#if FRACTALS_KERNELS_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "EscapeLoops.inl"
+
+namespace
+{
+#if FRACTALS_KERNELS_X86
+	bool DetectISA(kernels::KernelISA isa)
+	{
+#if defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+		const bool ymmState = (xcr0 & 0x6) == 0x6;
+		const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+		bool avx2 = false;
+		bool avx512 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+			avx512 = (info[1] & (1 << 16)) != 0;
+		}
+
+		switch (isa)
+		{
+		case kernels::KernelISA::SSE2:
+			return sse2;
+		case kernels::KernelISA::AVX2:
+			return avx && avx2 && ymmState;
+		case kernels::KernelISA::AVX512:
+			return avx && avx512 && ymmState && zmmState;
+		default:
+			return false;
+		}
+#else
+		__builtin_cpu_init();
+		switch (isa)
+		{
+		case kernels::KernelISA::SSE2:
+			return __builtin_cpu_supports("sse2");
+		case kernels::KernelISA::AVX2:
+			return __builtin_cpu_supports("avx2");
+		case kernels::KernelISA::AVX512:
+			return __builtin_cpu_supports("avx512f");
+		default:
+			return false;
+		}
+#endif
+	}
+#endif
+
+	const kernels::KernelSet s_kernelSets[] = {
+		{ kernels::KernelISA::SCALAR, "Scalar", &kernels::SmoothIterationsScalar, &kernels::DistanceScalar,
+			&kernels::SmoothIterationsDoubleDoubleScalar, &kernels::DistanceDoubleDoubleScalar },
+#if FRACTALS_KERNELS_X86
+		{ kernels::KernelISA::SSE2, "SSE2", &kernels::SmoothIterationsSSE2, &kernels::DistanceSSE2,
+			&kernels::SmoothIterationsDoubleDoubleSSE2, &kernels::DistanceDoubleDoubleSSE2 },
+		{ kernels::KernelISA::AVX2, "AVX2", &kernels::SmoothIterationsAVX2, &kernels::DistanceAVX2,
+			&kernels::SmoothIterationsDoubleDoubleAVX2, &kernels::DistanceDoubleDoubleAVX2 },
+		{ kernels::KernelISA::AVX512, "AVX-512", &kernels::SmoothIterationsAVX512, &kernels::DistanceAVX512,
+			&kernels::SmoothIterationsDoubleDoubleAVX512, &kernels::DistanceDoubleDoubleAVX512 },
+#endif
+	};
+}
+
+namespace kernels
+{
+	bool IsSupported(KernelISA isa)
+	{
+		if (isa == KernelISA::SCALAR)
+		{
+			return true;
+		}
+#if FRACTALS_KERNELS_X86
+		if (isa < KernelISA::COUNT)
+		{
+			static const bool s_supported[] = {
+				true,
+				DetectISA(KernelISA::SSE2),
+				DetectISA(KernelISA::AVX2),
+				DetectISA(KernelISA::AVX512),
+			};
+			return s_supported[static_cast<size_t>(isa)];
+		}
+#endif
+		return false;
+	}
+
+	const KernelSet& GetKernelSet(KernelISA isa)
+	{
+		for (const KernelSet& set : s_kernelSets)
+		{
+			if (set.isa == isa && IsSupported(isa))
+			{
+				return set;
+			}
+		}
+		return s_kernelSets[0];
+	}
+
+	const KernelSet& SelectKernelSet()
+	{
+		static const KernelSet& s_selected = []() -> const KernelSet&
+		{
+			const KernelSet* best = &s_kernelSets[0];
+			for (const KernelSet& set : s_kernelSets)
+			{
+				if (IsSupported(set.isa))
+				{
+					best = &set;
+				}
+			}
+			return *best;
+		}();
+		return s_selected;
+	}
+
+	void SmoothIterationsScalar(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		SmoothIterationsLoop(params, cx, cy, count, outIterations, stats);
+	}
+
+	void DistanceScalar(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		DistanceLoop(params, cx, cy, count, outDistance, stats);
+	}
+}
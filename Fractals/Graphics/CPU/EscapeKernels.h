@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FRACTALS_KERNELS_X86 1
+#else
+#define FRACTALS_KERNELS_X86 0
+#endif
+
+namespace math
+{
+	struct doubledouble;
+}
+
+namespace kernels
+{
+	struct EscapeParams
+	{
+		double threshold;
+		double logThreshold;
+		int maxIterations;
+		// Brent cycle detection: an orbit point closer than this to the saved one ends the point as interior, 0 - off.
+		// Scaled with the pixel size by the caller, so it stays far below the distance between neighbouring pixels.
+		double periodicityTolerance;
+	};
+
+	// Counters accumulated by the kernels over all their calls
+	struct EscapeStats
+	{
+		// interior points stopped by periodicity detection before maxIterations
+		size_t periodicPoints = 0;
+		// points inside M1/M2, rejected by the bulb test without a single step
+		size_t bulbPoints = 0;
+		// points still bounded after maxIterations
+		size_t maxIterationPoints = 0;
+		// Z -> Z^2 + c steps over all points, iterations skipped by BLA steps included
+		size_t iterations = 0;
+
+		EscapeStats& operator+=(const EscapeStats& rhs)
+		{
+			periodicPoints += rhs.periodicPoints;
+			bulbPoints += rhs.bulbPoints;
+			maxIterationPoints += rhs.maxIterationPoints;
+			iterations += rhs.iterations;
+			return *this;
+		}
+	};
+
+	// Computes smooth iteration counts for `count` points c = (cx[i], cy[i]).
+	// Points inside M1/M2, caught by periodicity detection or not escaped after maxIterations produce 0.
+	using SmoothIterationsKernel = void(*)(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats);
+
+	// Computes the exterior distance estimate for `count` points, 0 for interior points.
+	using DistanceKernel = void(*)(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+	// Double-double variants for zooms where double runs out of digits (~1e13 .. ~1e28), same results at every ISA
+	using DoubleDoubleSmoothIterationsKernel = void(*)(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats);
+	using DoubleDoubleDistanceKernel = void(*)(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+	enum class KernelISA
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+		AVX512,
+		COUNT
+	};
+
+	struct KernelSet
+	{
+		KernelISA isa;
+		const char* name;
+		SmoothIterationsKernel smoothIterations;
+		DistanceKernel distance;
+		DoubleDoubleSmoothIterationsKernel smoothIterationsDoubleDouble;
+		DoubleDoubleDistanceKernel distanceDoubleDouble;
+	};
+
+	bool IsSupported(KernelISA isa);
+
+	// Returns the kernels for the requested instruction set, falls back to scalar when it is not supported
+	const KernelSet& GetKernelSet(KernelISA isa);
+
+	// Returns the fastest kernels supported by the running CPU, detected once on first use
+	const KernelSet& SelectKernelSet();
+
+	void SmoothIterationsScalar(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceScalar(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+	// the per-point loops instantiated on math::doubledouble
+	void SmoothIterationsDoubleDoubleScalar(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceDoubleDoubleScalar(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+#if FRACTALS_KERNELS_X86
+	void SmoothIterationsSSE2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceSSE2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats);
+	void SmoothIterationsDoubleDoubleSSE2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceDoubleDoubleSSE2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+	void SmoothIterationsAVX2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceAVX2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats);
+	void SmoothIterationsDoubleDoubleAVX2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceDoubleDoubleAVX2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats);
+
+	void SmoothIterationsAVX512(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceAVX512(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats);
+	void SmoothIterationsDoubleDoubleAVX512(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats);
+	void DistanceDoubleDoubleAVX512(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats);
+#endif
+}
@@ -0,0 +1,64 @@
+#include "EscapeKernels.h"
+
+#if FRACTALS_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace
+{
+	struct AVX2Lanes
+	{
+		using vec = __m256d;
+		using mask = __m256d;
+		static constexpr size_t width = 4;
+
+		static vec set1(double value) { return _mm256_set1_pd(value); }
+		static vec load(const double* src) { return _mm256_loadu_pd(src); }
+		static void store(double* dst, vec value) { _mm256_storeu_pd(dst, value); }
+
+		static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+		static vec sub(vec a, vec b) { return _mm256_sub_pd(a, b); }
+		static vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+
+		static mask gt(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		static mask lt(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+
+		static mask maskAll() { return _mm256_castsi256_pd(_mm256_set1_epi32(-1)); }
+		static mask maskNone() { return _mm256_setzero_pd(); }
+		static mask maskAnd(mask a, mask b) { return _mm256_and_pd(a, b); }
+		static mask maskOr(mask a, mask b) { return _mm256_or_pd(a, b); }
+		static mask maskAndNot(mask a, mask b) { return _mm256_andnot_pd(b, a); }
+		static bool any(mask m) { return _mm256_movemask_pd(m) != 0; }
+		static int bits(mask m) { return _mm256_movemask_pd(m); }
+
+		static vec select(mask m, vec a, vec b) { return _mm256_blendv_pd(b, a, m); }
+	};
+}
+
+#include "EscapeKernelsSIMD.inl"
+#include "EscapeKernelsDoubleDoubleSIMD.inl"
+
+namespace kernels
+{
+	void SmoothIterationsAVX2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunBlocks<AVX2Lanes>(&SmoothIterationsBlock<AVX2Lanes>, params, cx, cy, count, outIterations, stats);
+	}
+
+	void DistanceAVX2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunBlocks<AVX2Lanes>(&DistanceBlock<AVX2Lanes>, params, cx, cy, count, outDistance, stats);
+	}
+
+	void SmoothIterationsDoubleDoubleAVX2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<AVX2Lanes>(&SmoothIterationsDoubleDoubleBlock<AVX2Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outIterations, stats);
+	}
+
+	void DistanceDoubleDoubleAVX2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<AVX2Lanes>(&DistanceDoubleDoubleBlock<AVX2Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outDistance, stats);
+	}
+}
+
+#endif
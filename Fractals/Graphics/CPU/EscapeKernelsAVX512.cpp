@@ -0,0 +1,64 @@
+#include "EscapeKernels.h"
+
+#if FRACTALS_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace
+{
+	struct AVX512Lanes
+	{
+		using vec = __m512d;
+		using mask = __mmask8;
+		static constexpr size_t width = 8;
+
+		static vec set1(double value) { return _mm512_set1_pd(value); }
+		static vec load(const double* src) { return _mm512_loadu_pd(src); }
+		static void store(double* dst, vec value) { _mm512_storeu_pd(dst, value); }
+
+		static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+		static vec sub(vec a, vec b) { return _mm512_sub_pd(a, b); }
+		static vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+
+		static mask gt(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+		static mask lt(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+
+		static mask maskAll() { return static_cast<mask>(0xFF); }
+		static mask maskNone() { return static_cast<mask>(0); }
+		static mask maskAnd(mask a, mask b) { return static_cast<mask>(a & b); }
+		static mask maskOr(mask a, mask b) { return static_cast<mask>(a | b); }
+		static mask maskAndNot(mask a, mask b) { return static_cast<mask>(a & ~b); }
+		static bool any(mask m) { return m != 0; }
+		static int bits(mask m) { return m; }
+
+		static vec select(mask m, vec a, vec b) { return _mm512_mask_blend_pd(m, b, a); }
+	};
+}
+
+#include "EscapeKernelsSIMD.inl"
+#include "EscapeKernelsDoubleDoubleSIMD.inl"
+
+namespace kernels
+{
+	void SmoothIterationsAVX512(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunBlocks<AVX512Lanes>(&SmoothIterationsBlock<AVX512Lanes>, params, cx, cy, count, outIterations, stats);
+	}
+
+	void DistanceAVX512(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunBlocks<AVX512Lanes>(&DistanceBlock<AVX512Lanes>, params, cx, cy, count, outDistance, stats);
+	}
+
+	void SmoothIterationsDoubleDoubleAVX512(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<AVX512Lanes>(&SmoothIterationsDoubleDoubleBlock<AVX512Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outIterations, stats);
+	}
+
+	void DistanceDoubleDoubleAVX512(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<AVX512Lanes>(&DistanceDoubleDoubleBlock<AVX512Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outDistance, stats);
+	}
+}
+
+#endif
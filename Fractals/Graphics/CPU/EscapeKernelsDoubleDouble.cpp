@@ -0,0 +1,22 @@
+#include "EscapeKernels.h"
+
+#include <type_traits>
+
+#include "Math/doubledouble.h"
+#include "EscapeLoops.inl"
+
+// the SIMD kernels read the points as hi/lo pairs of doubles
+static_assert(std::is_standard_layout_v<math::doubledouble> && sizeof(math::doubledouble) == 2 * sizeof(double));
+
+namespace kernels
+{
+	void SmoothIterationsDoubleDoubleScalar(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		SmoothIterationsLoop(params, cx, cy, count, outIterations, stats);
+	}
+
+	void DistanceDoubleDoubleScalar(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		DistanceLoop(params, cx, cy, count, outDistance, stats);
+	}
+}
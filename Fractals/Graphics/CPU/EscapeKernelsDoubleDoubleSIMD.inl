@@ -0,0 +1,365 @@
+// Lane-parallel double-double escape-time kernels shared by the per-ISA translation units.
+// Included after EscapeKernelsSIMD.inl and instantiated with the same lane traits. math::doubledouble is not
+// included here: its inline functions would be compiled with the wider ISA flags of the including file.
+// The points come as hi/lo pairs in the memory layout of math::doubledouble. Every operation follows
+// math::doubledouble and the order of SmoothIterationsLoop/DistanceLoop, so the results stay bit-identical
+// to kernels::SmoothIterationsDoubleDoubleScalar/DistanceDoubleDoubleScalar.
+
+namespace
+{
+	template<class V>
+	struct DoubleDoubleLanes
+	{
+		typename V::vec hi;
+		typename V::vec lo;
+	};
+
+	template<class V>
+	DoubleDoubleLanes<V> MakeLanes(const typename V::vec hi, const typename V::vec lo)
+	{
+		DoubleDoubleLanes<V> result;
+		result.hi = hi;
+		result.lo = lo;
+		return result;
+	}
+
+	// s + e = a + b exactly
+	template<class V>
+	DoubleDoubleLanes<V> TwoSum(const typename V::vec a, const typename V::vec b)
+	{
+		const typename V::vec s = V::add(a, b);
+		const typename V::vec bb = V::sub(s, a);
+		const typename V::vec e = V::add(V::sub(a, V::sub(s, bb)), V::sub(b, bb));
+		return MakeLanes<V>(s, e);
+	}
+
+	// s + e = a + b exactly, requires |a| >= |b|
+	template<class V>
+	DoubleDoubleLanes<V> QuickTwoSum(const typename V::vec a, const typename V::vec b)
+	{
+		const typename V::vec s = V::add(a, b);
+		return MakeLanes<V>(s, V::sub(b, V::sub(s, a)));
+	}
+
+	// Veltkamp splitting, both halves hold at most 26 significant bits
+	template<class V>
+	void Split(const typename V::vec a, typename V::vec& outHi, typename V::vec& outLo)
+	{
+		const typename V::vec t = V::mul(V::set1(134217729.0), a); // 2^27 + 1
+		outHi = V::sub(t, V::sub(t, a));
+		outLo = V::sub(a, outHi);
+	}
+
+	// p + e = a * b exactly
+	template<class V>
+	DoubleDoubleLanes<V> TwoProd(const typename V::vec a, const typename V::vec b)
+	{
+		const typename V::vec p = V::mul(a, b);
+		typename V::vec aHi, aLo, bHi, bLo;
+		Split<V>(a, aHi, aLo);
+		Split<V>(b, bHi, bLo);
+		typename V::vec e = V::sub(V::mul(aHi, bHi), p);
+		e = V::add(e, V::mul(aHi, bLo));
+		e = V::add(e, V::mul(aLo, bHi));
+		e = V::add(e, V::mul(aLo, bLo));
+		return MakeLanes<V>(p, e);
+	}
+
+	template<class V>
+	DoubleDoubleLanes<V> Add(const DoubleDoubleLanes<V>& lhs, const DoubleDoubleLanes<V>& rhs)
+	{
+		const DoubleDoubleLanes<V> s = TwoSum<V>(lhs.hi, rhs.hi);
+		const DoubleDoubleLanes<V> t = TwoSum<V>(lhs.lo, rhs.lo);
+		const DoubleDoubleLanes<V> result = QuickTwoSum<V>(s.hi, V::add(s.lo, t.hi));
+		return QuickTwoSum<V>(result.hi, V::add(result.lo, t.lo));
+	}
+
+	template<class V>
+	DoubleDoubleLanes<V> Sub(const DoubleDoubleLanes<V>& lhs, const DoubleDoubleLanes<V>& rhs)
+	{
+		// -1 * x negates zeros too, as the unary minus of math::doubledouble
+		const typename V::vec minusOne = V::set1(-1.0);
+		return Add<V>(lhs, MakeLanes<V>(V::mul(minusOne, rhs.hi), V::mul(minusOne, rhs.lo)));
+	}
+
+	template<class V>
+	DoubleDoubleLanes<V> Mul(const DoubleDoubleLanes<V>& lhs, const DoubleDoubleLanes<V>& rhs)
+	{
+		const DoubleDoubleLanes<V> p = TwoProd<V>(lhs.hi, rhs.hi);
+		return QuickTwoSum<V>(p.hi, V::add(p.lo, V::add(V::mul(lhs.hi, rhs.lo), V::mul(lhs.lo, rhs.hi))));
+	}
+
+	template<class V>
+	DoubleDoubleLanes<V> Select(const typename V::mask m, const DoubleDoubleLanes<V>& a, const DoubleDoubleLanes<V>& b)
+	{
+		return MakeLanes<V>(V::select(m, a.hi, b.hi), V::select(m, a.lo, b.lo));
+	}
+
+	template<class V>
+	typename V::vec ToDouble(const DoubleDoubleLanes<V>& value)
+	{
+		return V::add(value.hi, value.lo);
+	}
+
+	// hi/lo pairs of V::width points
+	template<class V>
+	DoubleDoubleLanes<V> LoadPairs(const double* src)
+	{
+		alignas(64) double hi[V::width];
+		alignas(64) double lo[V::width];
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			hi[lane] = src[2 * lane];
+			lo[lane] = src[2 * lane + 1];
+		}
+		return MakeLanes<V>(V::load(hi), V::load(lo));
+	}
+
+	// |Z - saved|^2 < tolerance2, IsPeriodic of the scalar loop
+	template<class V>
+	typename V::mask IsPeriodicLanes(const DoubleDoubleLanes<V>& zx, const DoubleDoubleLanes<V>& zy, const DoubleDoubleLanes<V>& savedX, const DoubleDoubleLanes<V>& savedY, const typename V::vec tolerance2)
+	{
+		const DoubleDoubleLanes<V> dx = Sub<V>(zx, savedX);
+		const DoubleDoubleLanes<V> dy = Sub<V>(zy, savedY);
+		return V::lt(ToDouble<V>(Add<V>(Mul<V>(dx, dx), Mul<V>(dy, dy))), tolerance2);
+	}
+
+	template<class V>
+	void SmoothIterationsDoubleDoubleBlock(const kernels::EscapeParams& params, const double* cx, const double* cy, double* outIterations, kernels::EscapeStats& stats)
+	{
+		using vec = typename V::vec;
+		using mask = typename V::mask;
+		using dd = DoubleDoubleLanes<V>;
+
+		const vec threshold = V::set1(params.threshold);
+		const vec one = V::set1(1.0);
+		const vec zero = V::set1(0.0);
+		const dd two = MakeLanes<V>(V::set1(2.0), zero);
+		const dd c_x = LoadPairs<V>(cx);
+		const dd c_y = LoadPairs<V>(cy);
+
+		dd zx = MakeLanes<V>(zero, zero);
+		dd zy = MakeLanes<V>(zero, zero);
+		// the squares of Z are the ones of the escape test in the previous step, computed once
+		dd xx = Mul<V>(zx, zx);
+		dd yy = Mul<V>(zy, zy);
+		vec iterations = zero;
+		vec lastDotProduct = zero;
+		vec steps = zero;
+		const mask bulb = BulbMask<V>(ToDouble<V>(c_x), ToDouble<V>(c_y));
+		mask active = V::maskAndNot(V::maskAll(), bulb);
+
+		const double periodicityTolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = periodicityTolerance2 > 0.0;
+		const vec tolerance2 = V::set1(periodicityTolerance2);
+		dd savedX = zx;
+		dd savedY = zy;
+		mask periodic = V::maskNone();
+		int period = 1;
+		int sinceSave = 0;
+
+		for (int k = 0; k <= params.maxIterations && V::any(active); ++k)
+		{
+			// Z -> Z^2 + c
+			const dd nx = Add<V>(Sub<V>(xx, yy), c_x);
+			const dd ny = Add<V>(Mul<V>(Mul<V>(two, zx), zy), c_y);
+			zx = Select<V>(active, nx, zx);
+			zy = Select<V>(active, ny, zy);
+			steps = V::add(steps, V::select(active, one, zero));
+
+			const dd nxx = Mul<V>(zx, zx);
+			const dd nyy = Mul<V>(zy, zy);
+			xx = Select<V>(active, nxx, xx);
+			yy = Select<V>(active, nyy, yy);
+
+			const vec dotProduct = ToDouble<V>(Add<V>(xx, yy));
+			const mask escaped = V::maskAnd(active, V::gt(dotProduct, threshold));
+			lastDotProduct = V::select(escaped, dotProduct, lastDotProduct);
+			iterations = V::select(escaped, V::set1(static_cast<double>(k)), iterations);
+			active = V::maskAndNot(active, escaped);
+
+			if (checkPeriodicity)
+			{
+				const mask cycle = V::maskAnd(active, IsPeriodicLanes<V>(zx, zy, savedX, savedY, tolerance2));
+				periodic = V::maskOr(periodic, cycle);
+				active = V::maskAndNot(active, cycle);
+
+				if (++sinceSave == period)
+				{
+					sinceSave = 0;
+					period *= 2;
+					savedX = zx;
+					savedY = zy;
+				}
+			}
+		}
+		iterations = V::select(active, V::set1(params.maxIterations + 1.0), iterations);
+		stats.periodicPoints += CountBits(V::bits(periodic));
+		stats.bulbPoints += CountBits(V::bits(bulb));
+		stats.maxIterationPoints += CountBits(V::bits(active));
+		stats.iterations += SumLanes<V>(steps);
+
+		alignas(64) double laneIterations[V::width];
+		alignas(64) double laneDotProduct[V::width];
+		V::store(laneIterations, iterations);
+		V::store(laneDotProduct, lastDotProduct);
+
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			double it = laneIterations[lane];
+			if (it != 0 && it < params.maxIterations)
+			{
+				it += 1 - std::log(laneDotProduct[lane]) / params.logThreshold;
+			}
+			else
+			{
+				it = 0;
+			}
+			outIterations[lane] = it;
+		}
+	}
+
+	template<class V>
+	void DistanceDoubleDoubleBlock(const kernels::EscapeParams& params, const double* cx, const double* cy, double* outDistance, kernels::EscapeStats& stats)
+	{
+		using vec = typename V::vec;
+		using mask = typename V::mask;
+		using dd = DoubleDoubleLanes<V>;
+
+		const vec threshold = V::set1(params.threshold);
+		const vec two = V::set1(2.0);
+		const vec one = V::set1(1.0);
+		const vec zero = V::set1(0.0);
+		const dd twoWide = MakeLanes<V>(two, zero);
+		const dd c_x = LoadPairs<V>(cx);
+		const dd c_y = LoadPairs<V>(cy);
+
+		dd zx = MakeLanes<V>(zero, zero);
+		dd zy = MakeLanes<V>(zero, zero);
+		dd xx = Mul<V>(zx, zx);
+		dd yy = Mul<V>(zy, zy);
+		// double is enough for the derivative
+		vec dzx = zero;
+		vec dzy = zero;
+		vec m2 = zero;
+		vec steps = zero;
+		const mask bulb = BulbMask<V>(ToDouble<V>(c_x), ToDouble<V>(c_y));
+		mask active = V::maskAndNot(V::maskAll(), bulb);
+		mask escaped = V::maskNone();
+
+		const double periodicityTolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = periodicityTolerance2 > 0.0;
+		const vec tolerance2 = V::set1(periodicityTolerance2);
+		dd savedX = zx;
+		dd savedY = zy;
+		mask periodic = V::maskNone();
+		int period = 1;
+		int sinceSave = 0;
+
+		for (int i = 0; i < params.maxIterations; ++i)
+		{
+			const mask justEscaped = V::maskAnd(active, V::gt(m2, threshold));
+			escaped = V::maskOr(escaped, justEscaped);
+			active = V::maskAndNot(active, justEscaped);
+			if (!V::any(active))
+				break;
+
+			// Z' -> 2*Z*Z' + 1
+			const vec zdx = ToDouble<V>(zx);
+			const vec zdy = ToDouble<V>(zy);
+			const vec ndx = V::add(V::mul(two, V::sub(V::mul(zdx, dzx), V::mul(zdy, dzy))), one);
+			const vec ndy = V::add(V::mul(two, V::add(V::mul(zdx, dzy), V::mul(zdy, dzx))), zero);
+
+			// Z -> Z^2 + c
+			const dd nx = Add<V>(Sub<V>(xx, yy), c_x);
+			const dd ny = Add<V>(Mul<V>(Mul<V>(twoWide, zx), zy), c_y);
+
+			dzx = V::select(active, ndx, dzx);
+			dzy = V::select(active, ndy, dzy);
+			zx = Select<V>(active, nx, zx);
+			zy = Select<V>(active, ny, zy);
+			steps = V::add(steps, V::select(active, one, zero));
+
+			const dd nxx = Mul<V>(zx, zx);
+			const dd nyy = Mul<V>(zy, zy);
+			xx = Select<V>(active, nxx, xx);
+			yy = Select<V>(active, nyy, yy);
+			m2 = V::select(active, ToDouble<V>(Add<V>(xx, yy)), m2);
+
+			if (checkPeriodicity)
+			{
+				// lanes about to escape are left to the escape test, as in the scalar loop
+				const mask bounded = V::maskAndNot(active, V::gt(m2, threshold));
+				const mask cycle = V::maskAnd(bounded, IsPeriodicLanes<V>(zx, zy, savedX, savedY, tolerance2));
+				periodic = V::maskOr(periodic, cycle);
+				active = V::maskAndNot(active, cycle);
+
+				if (++sinceSave == period)
+				{
+					sinceSave = 0;
+					period *= 2;
+					savedX = zx;
+					savedY = zy;
+				}
+			}
+		}
+		stats.periodicPoints += CountBits(V::bits(periodic));
+		stats.bulbPoints += CountBits(V::bits(bulb));
+		stats.maxIterationPoints += CountBits(V::bits(active));
+		stats.iterations += SumLanes<V>(steps);
+
+		alignas(64) double laneZx[V::width];
+		alignas(64) double laneZy[V::width];
+		alignas(64) double laneDzx[V::width];
+		alignas(64) double laneDzy[V::width];
+		V::store(laneZx, ToDouble<V>(zx));
+		V::store(laneZy, ToDouble<V>(zy));
+		V::store(laneDzx, dzx);
+		V::store(laneDzy, dzy);
+		const int escapedBits = V::bits(escaped);
+
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			double distance = 0.0;
+			if (escapedBits & (1 << lane))
+			{
+				// d(c) = |Z|*log|Z|/|Z'|
+				const double z2 = laneZx[lane] * laneZx[lane] + laneZy[lane] * laneZy[lane];
+				const double dz2 = laneDzx[lane] * laneDzx[lane] + laneDzy[lane] * laneDzy[lane];
+				distance = 0.5 * std::sqrt(z2 / dz2) * std::log(z2);
+			}
+			outDistance[lane] = distance;
+		}
+	}
+
+	// RunBlocks over hi/lo pairs, the tail is padded with c = 0 as well
+	template<class V, class Block>
+	void RunDoubleDoubleBlocks(Block block, const kernels::EscapeParams& params, const double* cx, const double* cy, size_t count, double* out, kernels::EscapeStats& stats)
+	{
+		size_t i = 0;
+		for (; i + V::width <= count; i += V::width)
+		{
+			block(params, cx + 2 * i, cy + 2 * i, out + i, stats);
+		}
+
+		if (i < count)
+		{
+			const size_t tail = count - i;
+			double tailX[2 * V::width] = {};
+			double tailY[2 * V::width] = {};
+			alignas(64) double tailOut[V::width] = {};
+			for (size_t j = 0; j < 2 * tail; ++j)
+			{
+				tailX[j] = cx[2 * i + j];
+				tailY[j] = cy[2 * i + j];
+			}
+			block(params, tailX, tailY, tailOut, stats);
+			// the padding is not part of the frame
+			stats.bulbPoints -= V::width - tail;
+			for (size_t lane = 0; lane < tail; ++lane)
+			{
+				out[i + lane] = tailOut[lane];
+			}
+		}
+	}
+}
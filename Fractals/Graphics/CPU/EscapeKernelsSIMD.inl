@@ -0,0 +1,284 @@
+// Lane-parallel escape-time kernels shared by the per-ISA translation units.
+// Kept free of standard library templates: the including file may be compiled with wider ISA flags.
+// The including file defines the lane traits (vector/mask types and operations) and instantiates
+// the templates below. Every operation is evaluated in the same order as the scalar kernels so
+// results stay bit-identical to kernels::SmoothIterationsScalar/DistanceScalar.
+
+#include <cmath>
+
+namespace
+{
+	template<class V>
+	typename V::mask BulbMask(const typename V::vec cx, const typename V::vec cy)
+	{
+		const typename V::vec c2 = V::add(V::mul(cx, cx), V::mul(cy, cy));
+
+		// M1 - 256*c2*c2 - 96*c2 + 32*c.x - 3 < 0
+		typename V::vec m1 = V::mul(V::mul(V::set1(256.0), c2), c2);
+		m1 = V::sub(m1, V::mul(V::set1(96.0), c2));
+		m1 = V::add(m1, V::mul(V::set1(32.0), cx));
+		m1 = V::sub(m1, V::set1(3.0));
+
+		// M2 - 16*(c2 + 2*c.x + 1) - 1 < 0
+		typename V::vec m2 = V::add(V::add(c2, V::mul(V::set1(2.0), cx)), V::set1(1.0));
+		m2 = V::sub(V::mul(V::set1(16.0), m2), V::set1(1.0));
+
+		const typename V::vec zero = V::set1(0.0);
+		return V::maskOr(V::lt(m1, zero), V::lt(m2, zero));
+	}
+
+	// squared distance of Z from the point saved by the periodicity check
+	template<class V>
+	typename V::vec DistanceFromSaved2(const typename V::vec zx, const typename V::vec zy, const typename V::vec savedX, const typename V::vec savedY)
+	{
+		const typename V::vec dx = V::sub(zx, savedX);
+		const typename V::vec dy = V::sub(zy, savedY);
+		return V::add(V::mul(dx, dx), V::mul(dy, dy));
+	}
+
+	size_t CountBits(int bits)
+	{
+		size_t count = 0;
+		for (; bits != 0; bits &= bits - 1)
+		{
+			++count;
+		}
+		return count;
+	}
+
+	// iterations counted per lane in a vector, one add per step instead of a mask count
+	template<class V>
+	size_t SumLanes(const typename V::vec steps)
+	{
+		alignas(64) double laneSteps[V::width];
+		V::store(laneSteps, steps);
+		double sum = 0.0;
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			sum += laneSteps[lane];
+		}
+		return static_cast<size_t>(sum);
+	}
+
+	template<class V>
+	void SmoothIterationsBlock(const kernels::EscapeParams& params, const double* cx, const double* cy, double* outIterations, kernels::EscapeStats& stats)
+	{
+		using vec = typename V::vec;
+		using mask = typename V::mask;
+
+		const vec threshold = V::set1(params.threshold);
+		const vec two = V::set1(2.0);
+		const vec c_x = V::load(cx);
+		const vec c_y = V::load(cy);
+
+		vec zx = V::set1(0.0);
+		vec zy = V::set1(0.0);
+		vec iterations = V::set1(0.0);
+		vec lastDotProduct = V::set1(0.0);
+		vec steps = V::set1(0.0);
+		const vec one = V::set1(1.0);
+		const vec zero = V::set1(0.0);
+		const mask bulb = BulbMask<V>(c_x, c_y);
+		mask active = V::maskAndNot(V::maskAll(), bulb);
+
+		// same schedule as PeriodicityCheck in the scalar loop, all lanes start at the same iteration
+		const double periodicityTolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = periodicityTolerance2 > 0.0;
+		const vec tolerance2 = V::set1(periodicityTolerance2);
+		vec savedX = V::set1(0.0);
+		vec savedY = V::set1(0.0);
+		mask periodic = V::maskNone();
+		int period = 1;
+		int sinceSave = 0;
+
+		for (int k = 0; k <= params.maxIterations && V::any(active); ++k)
+		{
+			// Z -> Z^2 + c
+			const vec nx = V::add(V::sub(V::mul(zx, zx), V::mul(zy, zy)), c_x);
+			const vec ny = V::add(V::mul(V::mul(two, zx), zy), c_y);
+			zx = V::select(active, nx, zx);
+			zy = V::select(active, ny, zy);
+			steps = V::add(steps, V::select(active, one, zero));
+
+			const vec dotProduct = V::add(V::mul(zx, zx), V::mul(zy, zy));
+			const mask escaped = V::maskAnd(active, V::gt(dotProduct, threshold));
+			lastDotProduct = V::select(escaped, dotProduct, lastDotProduct);
+			iterations = V::select(escaped, V::set1(static_cast<double>(k)), iterations);
+			active = V::maskAndNot(active, escaped);
+
+			if (checkPeriodicity)
+			{
+				// caught lanes keep 0 iterations and are colored as interior
+				const mask cycle = V::maskAnd(active, V::lt(DistanceFromSaved2<V>(zx, zy, savedX, savedY), tolerance2));
+				periodic = V::maskOr(periodic, cycle);
+				active = V::maskAndNot(active, cycle);
+
+				if (++sinceSave == period)
+				{
+					sinceSave = 0;
+					period *= 2;
+					savedX = zx;
+					savedY = zy;
+				}
+			}
+		}
+		iterations = V::select(active, V::set1(params.maxIterations + 1.0), iterations);
+		stats.periodicPoints += CountBits(V::bits(periodic));
+		stats.bulbPoints += CountBits(V::bits(bulb));
+		stats.maxIterationPoints += CountBits(V::bits(active));
+		stats.iterations += SumLanes<V>(steps);
+
+		alignas(64) double laneIterations[V::width];
+		alignas(64) double laneDotProduct[V::width];
+		V::store(laneIterations, iterations);
+		V::store(laneDotProduct, lastDotProduct);
+
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			double it = laneIterations[lane];
+			if (it != 0 && it < params.maxIterations)
+			{
+				it += 1 - std::log(laneDotProduct[lane]) / params.logThreshold;
+			}
+			else
+			{
+				it = 0;
+			}
+			outIterations[lane] = it;
+		}
+	}
+
+	template<class V>
+	void DistanceBlock(const kernels::EscapeParams& params, const double* cx, const double* cy, double* outDistance, kernels::EscapeStats& stats)
+	{
+		using vec = typename V::vec;
+		using mask = typename V::mask;
+
+		const vec threshold = V::set1(params.threshold);
+		const vec two = V::set1(2.0);
+		const vec one = V::set1(1.0);
+		const vec zero = V::set1(0.0);
+		const vec c_x = V::load(cx);
+		const vec c_y = V::load(cy);
+
+		vec zx = zero;
+		vec zy = zero;
+		vec dzx = zero;
+		vec dzy = zero;
+		vec m2 = zero;
+		vec steps = zero;
+		const mask bulb = BulbMask<V>(c_x, c_y);
+		mask active = V::maskAndNot(V::maskAll(), bulb);
+		mask escaped = V::maskNone();
+
+		const double periodicityTolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = periodicityTolerance2 > 0.0;
+		const vec tolerance2 = V::set1(periodicityTolerance2);
+		vec savedX = zero;
+		vec savedY = zero;
+		mask periodic = V::maskNone();
+		int period = 1;
+		int sinceSave = 0;
+
+		for (int i = 0; i < params.maxIterations; ++i)
+		{
+			const mask justEscaped = V::maskAnd(active, V::gt(m2, threshold));
+			escaped = V::maskOr(escaped, justEscaped);
+			active = V::maskAndNot(active, justEscaped);
+			if (!V::any(active))
+				break;
+
+			// Z' -> 2*Z*Z' + 1
+			const vec ndx = V::add(V::mul(two, V::sub(V::mul(zx, dzx), V::mul(zy, dzy))), one);
+			const vec ndy = V::add(V::mul(two, V::add(V::mul(zx, dzy), V::mul(zy, dzx))), zero);
+
+			// Z -> Z^2 + c
+			const vec nx = V::add(V::sub(V::mul(zx, zx), V::mul(zy, zy)), c_x);
+			const vec ny = V::add(V::mul(V::mul(two, zx), zy), c_y);
+
+			dzx = V::select(active, ndx, dzx);
+			dzy = V::select(active, ndy, dzy);
+			zx = V::select(active, nx, zx);
+			zy = V::select(active, ny, zy);
+			steps = V::add(steps, V::select(active, one, zero));
+
+			m2 = V::add(V::mul(zx, zx), V::mul(zy, zy));
+
+			if (checkPeriodicity)
+			{
+				// lanes about to escape are left to the escape test, as in the scalar loop
+				const mask bounded = V::maskAndNot(active, V::gt(m2, threshold));
+				const mask cycle = V::maskAnd(bounded, V::lt(DistanceFromSaved2<V>(zx, zy, savedX, savedY), tolerance2));
+				periodic = V::maskOr(periodic, cycle);
+				active = V::maskAndNot(active, cycle);
+
+				if (++sinceSave == period)
+				{
+					sinceSave = 0;
+					period *= 2;
+					savedX = zx;
+					savedY = zy;
+				}
+			}
+		}
+		stats.periodicPoints += CountBits(V::bits(periodic));
+		stats.bulbPoints += CountBits(V::bits(bulb));
+		// lanes that ran out of iterations, the ones escaping at the last step included as in the scalar loop
+		stats.maxIterationPoints += CountBits(V::bits(active));
+		stats.iterations += SumLanes<V>(steps);
+
+		alignas(64) double laneZx[V::width];
+		alignas(64) double laneZy[V::width];
+		alignas(64) double laneDzx[V::width];
+		alignas(64) double laneDzy[V::width];
+		V::store(laneZx, zx);
+		V::store(laneZy, zy);
+		V::store(laneDzx, dzx);
+		V::store(laneDzy, dzy);
+		const int escapedBits = V::bits(escaped);
+
+		for (size_t lane = 0; lane < V::width; ++lane)
+		{
+			double distance = 0.0;
+			if (escapedBits & (1 << lane))
+			{
+				// d(c) = |Z|*log|Z|/|Z'|
+				const double z2 = laneZx[lane] * laneZx[lane] + laneZy[lane] * laneZy[lane];
+				const double dz2 = laneDzx[lane] * laneDzx[lane] + laneDzy[lane] * laneDzy[lane];
+				distance = 0.5 * std::sqrt(z2 / dz2) * std::log(z2);
+			}
+			outDistance[lane] = distance;
+		}
+	}
+
+	// Runs `Block` over full lane groups and pads the tail with c = 0, which the bulb test rejects at once
+	template<class V, class Block>
+	void RunBlocks(Block block, const kernels::EscapeParams& params, const double* cx, const double* cy, size_t count, double* out, kernels::EscapeStats& stats)
+	{
+		size_t i = 0;
+		for (; i + V::width <= count; i += V::width)
+		{
+			block(params, cx + i, cy + i, out + i, stats);
+		}
+
+		if (i < count)
+		{
+			const size_t tail = count - i;
+			alignas(64) double tailX[V::width] = {};
+			alignas(64) double tailY[V::width] = {};
+			alignas(64) double tailOut[V::width] = {};
+			for (size_t lane = 0; lane < tail; ++lane)
+			{
+				tailX[lane] = cx[i + lane];
+				tailY[lane] = cy[i + lane];
+			}
+			block(params, tailX, tailY, tailOut, stats);
+			// the padding is not part of the frame
+			stats.bulbPoints -= V::width - tail;
+			for (size_t lane = 0; lane < tail; ++lane)
+			{
+				out[i + lane] = tailOut[lane];
+			}
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#include "EscapeKernels.h"
+
+#if FRACTALS_KERNELS_X86
+
+#include <emmintrin.h>
+
+namespace
+{
+	struct SSE2Lanes
+	{
+		using vec = __m128d;
+		using mask = __m128d;
+		static constexpr size_t width = 2;
+
+		static vec set1(double value) { return _mm_set1_pd(value); }
+		static vec load(const double* src) { return _mm_loadu_pd(src); }
+		static void store(double* dst, vec value) { _mm_storeu_pd(dst, value); }
+
+		static vec add(vec a, vec b) { return _mm_add_pd(a, b); }
+		static vec sub(vec a, vec b) { return _mm_sub_pd(a, b); }
+		static vec mul(vec a, vec b) { return _mm_mul_pd(a, b); }
+
+		static mask gt(vec a, vec b) { return _mm_cmpgt_pd(a, b); }
+		static mask lt(vec a, vec b) { return _mm_cmplt_pd(a, b); }
+
+		static mask maskAll() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+		static mask maskNone() { return _mm_setzero_pd(); }
+		static mask maskAnd(mask a, mask b) { return _mm_and_pd(a, b); }
+		static mask maskOr(mask a, mask b) { return _mm_or_pd(a, b); }
+		static mask maskAndNot(mask a, mask b) { return _mm_andnot_pd(b, a); }
+		static bool any(mask m) { return _mm_movemask_pd(m) != 0; }
+		static int bits(mask m) { return _mm_movemask_pd(m); }
+
+		static vec select(mask m, vec a, vec b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+	};
+}
+
+#include "EscapeKernelsSIMD.inl"
+#include "EscapeKernelsDoubleDoubleSIMD.inl"
+
+namespace kernels
+{
+	void SmoothIterationsSSE2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunBlocks<SSE2Lanes>(&SmoothIterationsBlock<SSE2Lanes>, params, cx, cy, count, outIterations, stats);
+	}
+
+	void DistanceSSE2(const EscapeParams& params, const double* cx, const double* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunBlocks<SSE2Lanes>(&DistanceBlock<SSE2Lanes>, params, cx, cy, count, outDistance, stats);
+	}
+
+	void SmoothIterationsDoubleDoubleSSE2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<SSE2Lanes>(&SmoothIterationsDoubleDoubleBlock<SSE2Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outIterations, stats);
+	}
+
+	void DistanceDoubleDoubleSSE2(const EscapeParams& params, const math::doubledouble* cx, const math::doubledouble* cy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		RunDoubleDoubleBlocks<SSE2Lanes>(&DistanceDoubleDoubleBlock<SSE2Lanes>, params, reinterpret_cast<const double*>(cx), reinterpret_cast<const double*>(cy), count, outDistance, stats);
+	}
+}
+
+#endif
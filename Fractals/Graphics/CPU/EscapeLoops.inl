@@ -0,0 +1,203 @@
+// Per-point escape-time loops templated on the scalar type of Z and c.
+// Instantiated for double by the scalar kernels and for math::doubledouble by the double-double kernels.
+// Kept in an anonymous namespace like EscapeKernelsSIMD.inl: the including files use different FP flags.
+
+#include <cmath>
+
+#include "Math/vec.h"
+
+namespace
+{
+	bool IsBulb(const math::vec2d& c)
+	{
+		const double c2 = math::dot(c, c);
+		// skip computation inside M1 - http://iquilezles.org/www/articles/mset_1bulb/mset1bulb.htm
+		return (256.0 * c2 * c2 - 96.0 * c2 + 32.0 * c.x - 3.0 < 0.0)
+			// skip computation inside M2 - http://iquilezles.org/www/articles/mset_2bulb/mset2bulb.htm
+			|| (16.0 * (c2 + 2.0 * c.x + 1.0) - 1.0 < 0.0);
+	}
+
+	// Brent's cycle detection: the orbit is compared with a point saved at growing power of two intervals,
+	// so a cycle of any period is found within about twice its length after the orbit settles into it
+	struct PeriodicityCheck
+	{
+		int period = 1;
+		int sinceSave = 0;
+
+		// true when the saved point has to be replaced by the current one
+		bool Advance()
+		{
+			if (++sinceSave < period)
+				return false;
+
+			sinceSave = 0;
+			period *= 2;
+			return true;
+		}
+	};
+
+	template<class Real>
+	bool IsPeriodic(const math::vec2<Real>& z, const math::vec2<Real>& saved, double tolerance2)
+	{
+		const math::vec2<Real> d = z - saved;
+		return math::toDouble(math::dot(d, d)) < tolerance2;
+	}
+
+	template<class Real>
+	void SmoothIterationsLoop(const kernels::EscapeParams& params, const Real* cx, const Real* cy, size_t count, double* outIterations, kernels::EscapeStats& stats)
+	{
+		const double threshold = params.threshold;
+		const double logthreshold = params.logThreshold;
+		const int maxIterations = params.maxIterations;
+		const double tolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = tolerance2 > 0.0;
+		size_t steps = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const math::vec2<Real> c(cx[i], cy[i]);
+			math::vec2<Real> z;
+
+			double iterations = 0;
+			double lastDotProduct = 0;
+
+			if (!IsBulb(math::vec2d(math::toDouble(c.x), math::toDouble(c.y))))
+			{
+				math::vec2<Real> saved;
+				PeriodicityCheck periodicity;
+
+				while (iterations <= maxIterations)
+				{
+					// Z -> Z^2 + c
+					z = math::vec2<Real>(z.x * z.x - z.y * z.y + c.x, 2 * z.x * z.y + c.y);
+					++steps;
+					//
+
+					lastDotProduct = math::toDouble(math::dot(z, z));
+					if (lastDotProduct > threshold)
+						break;
+
+					if (checkPeriodicity)
+					{
+						if (IsPeriodic(z, saved, tolerance2))
+						{
+							// attracting cycle, colored as interior
+							iterations = 0;
+							++stats.periodicPoints;
+							break;
+						}
+
+						if (periodicity.Advance())
+						{
+							saved = z;
+						}
+					}
+
+					++iterations;
+				}
+
+				if (iterations > maxIterations)
+				{
+					++stats.maxIterationPoints;
+				}
+			}
+			else
+			{
+				++stats.bulbPoints;
+			}
+
+			if (iterations != 0 && iterations < maxIterations)
+			{
+				iterations += 1 - std::log(lastDotProduct) / logthreshold;
+			}
+			else
+			{
+				iterations = 0;
+			}
+
+			outIterations[i] = iterations;
+		}
+		stats.iterations += steps;
+	}
+
+	template<class Real>
+	void DistanceLoop(const kernels::EscapeParams& params, const Real* cx, const Real* cy, size_t count, double* outDistance, kernels::EscapeStats& stats)
+	{
+		const double threshold = params.threshold;
+		const int maxIterations = params.maxIterations;
+		const double tolerance2 = params.periodicityTolerance * params.periodicityTolerance;
+		const bool checkPeriodicity = tolerance2 > 0.0;
+		size_t steps = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const math::vec2<Real> c(cx[i], cy[i]);
+
+			double distance = 0.0;
+			if (!IsBulb(math::vec2d(math::toDouble(c.x), math::toDouble(c.y))))
+			{
+				// iterate
+				double di = 1.0;
+				math::vec2<Real> z;
+				double m2 = 0.0;
+				math::vec2d dz;
+				math::vec2<Real> saved;
+				PeriodicityCheck periodicity;
+				bool periodic = false;
+				for (int n = 0; n < maxIterations; n++)
+				{
+					if (m2 > threshold)
+					{
+						di = 0.0;
+						break;
+					}
+
+					// Z' -> 2*Z*Z' + 1, double is enough for the derivative
+					const math::vec2d zd(math::toDouble(z.x), math::toDouble(z.y));
+					dz = 2.0 * math::vec2d(zd.x * dz.x - zd.y * dz.y, zd.x * dz.y + zd.y * dz.x) + math::vec2d(1.0, 0.0);
+
+					// Z -> Z^2 + c
+					z = math::vec2<Real>(z.x * z.x - z.y * z.y + c.x, 2 * z.x * z.y + c.y);
+					++steps;
+
+					m2 = math::toDouble(math::dot(z, z));
+
+					if (checkPeriodicity && m2 <= threshold)
+					{
+						if (IsPeriodic(z, saved, tolerance2))
+						{
+							// attracting cycle, no distance for interior points
+							++stats.periodicPoints;
+							periodic = true;
+							break;
+						}
+
+						if (periodicity.Advance())
+						{
+							saved = z;
+						}
+					}
+				}
+
+				if (di <= 0.5)
+				{
+					// distance
+					// d(c) = |Z|*log|Z|/|Z'|
+					const math::vec2d zd(math::toDouble(z.x), math::toDouble(z.y));
+					distance = 0.5 * std::sqrt(math::dot(zd, zd) / math::dot(dz, dz)) * std::log(math::dot(zd, zd));
+				}
+				else if (!periodic)
+				{
+					++stats.maxIterationPoints;
+				}
+			}
+			else
+			{
+				++stats.bulbPoints;
+			}
+
+			outDistance[i] = distance;
+		}
+		stats.iterations += steps;
+	}
+}
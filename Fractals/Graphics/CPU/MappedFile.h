@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-write mapping of a whole file, created or resized to the requested size.
+// Writes go to the page cache and reach the file without explicit I/O, also when the process dies.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps `size` bytes of the file at `path`, previous contents past the new size are dropped
+	bool Open(const std::string& path, size_t size);
+	void Close();
+
+	bool IsOpen() const;
+	unsigned char* GetData() const;
+	size_t GetSize() const;
+
+private:
+	unsigned char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
@@ -0,0 +1,232 @@
+#include "PerturbationKernels.h"
+
+#include <cmath>
+
+#include "ReferenceOrbit.h"
+#include "BLATable.h"
+#include "Math/vec.h"
+
+namespace
+{
+	bool IsBulb(const math::vec2d& c)
+	{
+		const double c2 = math::dot(c, c);
+		return (256.0 * c2 * c2 - 96.0 * c2 + 32.0 * c.x - 3.0 < 0.0)
+			|| (16.0 * (c2 + 2.0 * c.x + 1.0) - 1.0 < 0.0);
+	}
+
+	template<class Real>
+	inline math::vec2<Real> Widen(const math::vec2d& value)
+	{
+		return math::vec2<Real>(value.x, value.y);
+	}
+
+	template<class Real>
+	inline math::vec2d Narrow(const math::vec2<Real>& value)
+	{
+		return math::vec2d(math::toDouble(value.x), math::toDouble(value.y));
+	}
+
+	// dz -> 2*Z*dz + dz^2 + dc
+	template<class Real>
+	inline math::vec2<Real> PerturbationStep(const math::vec2d& Z, const math::vec2<Real>& dz, const math::vec2<Real>& dc)
+	{
+		return math::vec2<Real>(
+			2.0 * (Z.x * dz.x - Z.y * dz.y) + (dz.x * dz.x - dz.y * dz.y) + dc.x,
+			2.0 * (Z.x * dz.y + Z.y * dz.x) + 2.0 * dz.x * dz.y + dc.y);
+	}
+
+	template<class Real>
+	inline math::vec2<Real> ComplexMul(const math::vec2d& a, const math::vec2<Real>& b)
+	{
+		return math::vec2<Real>(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+	}
+}
+
+namespace kernels
+{
+	template<class Real>
+	void SmoothIterationsPerturbation(const EscapeParams& params, const ReferenceOrbit& orbit, const BLATable* table, const Real* dcx, const Real* dcy, size_t count, double* outIterations, EscapeStats& stats)
+	{
+		using vec = math::vec2<Real>;
+
+		const math::vec2d* Z = orbit.GetPoints();
+		const size_t length = orbit.GetLength();
+		const math::vec2d referenceC(orbit.GetCenter().x.toDouble(), orbit.GetCenter().y.toDouble());
+		const double maxSkipNorm = table ? table->GetMaxDeltaNorm() : 0.0;
+		size_t steps = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const vec dc(dcx[i], dcy[i]);
+
+			double iterations = 0;
+			double lastDotProduct = 0;
+
+			if (!IsBulb(referenceC + Narrow(dc)))
+			{
+				vec dz;
+				size_t n = 0;
+				while (iterations <= params.maxIterations)
+				{
+					const double deltaNorm = math::toDouble(math::dot(dz, dz));
+					const BLAStep* step = deltaNorm < maxSkipNorm ? table->Lookup(n, deltaNorm) : nullptr;
+					if (step && iterations + step->length <= params.maxIterations)
+					{
+						// skipped iterations stay close to the reference, which does not escape before its end
+						dz = ComplexMul(step->A, dz) + ComplexMul(step->B, dc);
+						n += step->length;
+						iterations += step->length;
+						steps += step->length;
+
+						const vec z = Widen<Real>(Z[n]) + dz;
+						if (math::dot(z, z) < math::dot(dz, dz) || n == length)
+						{
+							dz = z;
+							n = 0;
+						}
+						continue;
+					}
+
+					dz = PerturbationStep(Z[n], dz, dc);
+					++n;
+					++steps;
+
+					const vec z = Widen<Real>(Z[n]) + dz;
+					const Real zNorm = math::dot(z, z);
+					lastDotProduct = math::toDouble(zNorm);
+					if (lastDotProduct > params.threshold)
+						break;
+
+					++iterations;
+
+					if (zNorm < math::dot(dz, dz) || n == length)
+					{
+						dz = z;
+						n = 0;
+					}
+				}
+
+				if (iterations > params.maxIterations)
+				{
+					++stats.maxIterationPoints;
+				}
+			}
+			else
+			{
+				++stats.bulbPoints;
+			}
+
+			if (iterations != 0 && iterations < params.maxIterations)
+			{
+				iterations += 1 - std::log(lastDotProduct) / params.logThreshold;
+			}
+			else
+			{
+				iterations = 0;
+			}
+
+			outIterations[i] = iterations;
+		}
+		stats.iterations += steps;
+	}
+
+	template<class Real>
+	void DistancePerturbation(const EscapeParams& params, const ReferenceOrbit& orbit, const BLATable* table, const Real* dcx, const Real* dcy, size_t count, double* outDistance, EscapeStats& stats)
+	{
+		using vec = math::vec2<Real>;
+		using std::sqrt;
+		using math::sqrt;
+		using std::log;
+		using math::log;
+
+		const math::vec2d* Z = orbit.GetPoints();
+		const size_t length = orbit.GetLength();
+		const math::vec2d referenceC(orbit.GetCenter().x.toDouble(), orbit.GetCenter().y.toDouble());
+		const double maxSkipNorm = table ? table->GetMaxDeltaNorm() : 0.0;
+		size_t steps = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const vec dc(dcx[i], dcy[i]);
+
+			double distance = 0.0;
+			if (!IsBulb(referenceC + Narrow(dc)))
+			{
+				double di = 1.0;
+				vec z;
+				vec dz;
+				vec derivative;
+				size_t n = 0;
+				Real m2 = 0.0;
+				for (int k = 0; k < params.maxIterations; k++)
+				{
+					if (m2 > params.threshold)
+					{
+						di = 0.0;
+						break;
+					}
+
+					const double deltaNorm = math::toDouble(math::dot(dz, dz));
+					const BLAStep* step = deltaNorm < maxSkipNorm ? table->Lookup(n, deltaNorm) : nullptr;
+					if (step && k + step->length <= params.maxIterations)
+					{
+						// Z' -> A*Z' + B, the derivative of the same linear map
+						derivative = ComplexMul(step->A, derivative) + Widen<Real>(step->B);
+						dz = ComplexMul(step->A, dz) + ComplexMul(step->B, dc);
+						n += step->length;
+						k += step->length - 1;
+						steps += step->length;
+
+						z = Widen<Real>(Z[n]) + dz;
+						m2 = math::dot(z, z);
+						if (m2 < math::dot(dz, dz) || n == length)
+						{
+							dz = z;
+							n = 0;
+						}
+						continue;
+					}
+
+					// Z' -> 2*Z*Z' + 1, on the full value Z + dz
+					derivative = 2.0 * vec(z.x * derivative.x - z.y * derivative.y, z.x * derivative.y + z.y * derivative.x) + vec(1.0, 0.0);
+
+					dz = PerturbationStep(Z[n], dz, dc);
+					++n;
+					++steps;
+
+					z = Widen<Real>(Z[n]) + dz;
+					m2 = math::dot(z, z);
+
+					if (m2 < math::dot(dz, dz) || n == length)
+					{
+						dz = z;
+						n = 0;
+					}
+				}
+
+				if (di <= 0.5)
+				{
+					// d(c) = |Z|*log|Z|/|Z'|
+					distance = math::toDouble(0.5 * sqrt(math::dot(z, z) / math::dot(derivative, derivative)) * log(math::dot(z, z)));
+				}
+				else
+				{
+					++stats.maxIterationPoints;
+				}
+			}
+			else
+			{
+				++stats.bulbPoints;
+			}
+
+			outDistance[i] = distance;
+		}
+		stats.iterations += steps;
+	}
+
+	template void SmoothIterationsPerturbation<double>(const EscapeParams&, const ReferenceOrbit&, const BLATable*, const double*, const double*, size_t, double*, EscapeStats&);
+	template void SmoothIterationsPerturbation<math::floatexp>(const EscapeParams&, const ReferenceOrbit&, const BLATable*, const math::floatexp*, const math::floatexp*, size_t, double*, EscapeStats&);
+	template void DistancePerturbation<double>(const EscapeParams&, const ReferenceOrbit&, const BLATable*, const double*, const double*, size_t, double*, EscapeStats&);
+	template void DistancePerturbation<math::floatexp>(const EscapeParams&, const ReferenceOrbit&, const BLATable*, const math::floatexp*, const math::floatexp*, size_t, double*, EscapeStats&);
+}
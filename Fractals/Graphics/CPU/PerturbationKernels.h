@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+#include "EscapeKernels.h"
+#include "Math/floatexp.h"
+
+class ReferenceOrbit;
+class BLATable;
+
+namespace kernels
+{
+	// Perturbation variants of the escape-time kernels. Every point is given as its offset dc from the
+	// reference point C of `orbit` and only the delta dz from the reference orbit Z is iterated:
+	//   dz -> 2*Z*dz + dz^2 + dc
+	// When |Z + dz| < |dz| or the reference orbit ends, the delta is rebased onto the start of the orbit.
+	// Results match SmoothIterationsScalar/DistanceScalar up to floating-point rounding.
+	// With a non-null `table` runs of iterations are skipped with its steps, see BLATable.h for the tolerance.
+	// Real is the type of the deltas: double, or math::floatexp once they underflow double (beyond ~1e300 zoom).
+	template<class Real>
+	void SmoothIterationsPerturbation(const EscapeParams& params, const ReferenceOrbit& orbit, const BLATable* table, const Real* dcx, const Real* dcy, size_t count, double* outIterations, EscapeStats& stats);
+	template<class Real>
+	void DistancePerturbation(const EscapeParams& params, const ReferenceOrbit& orbit, const BLATable* table, const Real* dcx, const Real* dcy, size_t count, double* outDistance, EscapeStats& stats);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Plane of pixels in heap memory, or in a mapped file once a path is set. The mapped plane starts
+// `headerSize` bytes into the file, room for an image header that the owner writes.
+// Offers the part of the std::vector interface the renderer uses.
+template<class T>
+class PixelStorage
+{
+public:
+	PixelStorage()
+		: m_headerSize(0)
+		, m_data(nullptr)
+		, m_size(0)
+	{
+	}
+
+	PixelStorage(PixelStorage&& other) noexcept
+		: PixelStorage()
+	{
+		*this = std::move(other);
+	}
+
+	PixelStorage& operator=(PixelStorage&& other) noexcept
+	{
+		m_heap = std::move(other.m_heap);
+		m_file = std::move(other.m_file);
+		m_path = std::move(other.m_path);
+		m_headerSize = other.m_headerSize;
+		m_data = other.m_data;
+		m_size = other.m_size;
+		other.m_data = nullptr;
+		other.m_size = 0;
+		return *this;
+	}
+
+	// An empty path goes back to the heap. Drops the contents, the next assign allocates the new storage.
+	void SetMappedFile(const std::string& path, size_t headerSize)
+	{
+		m_heap.clear();
+		m_heap.shrink_to_fit();
+		m_file.reset();
+		m_path = path;
+		m_headerSize = headerSize;
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	const std::string& GetMappedPath() const
+	{
+		return m_path;
+	}
+
+	// false also when the file of the path could not be mapped and the plane fell back to the heap
+	bool IsMapped() const
+	{
+		return m_file != nullptr;
+	}
+
+	// Start of the mapped file, null in heap memory
+	unsigned char* GetHeader() const
+	{
+		return m_file ? m_file->GetData() : nullptr;
+	}
+
+	void assign(size_t count, const T& value)
+	{
+		if (count != m_size)
+		{
+			Allocate(count);
+		}
+		std::fill(m_data, m_data + m_size, value);
+	}
+
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	T* begin() { return m_data; }
+	T* end() { return m_data + m_size; }
+	const T* begin() const { return m_data; }
+	const T* end() const { return m_data + m_size; }
+
+	T& operator[](size_t index) { return m_data[index]; }
+	const T& operator[](size_t index) const { return m_data[index]; }
+
+private:
+	void Allocate(size_t count)
+	{
+		m_file.reset();
+		if (!m_path.empty() && count > 0)
+		{
+			std::unique_ptr<MappedFile> file(new MappedFile());
+			if (file->Open(m_path, m_headerSize + count * sizeof(T)))
+			{
+				m_heap.clear();
+				m_heap.shrink_to_fit();
+				m_file = std::move(file);
+				m_data = reinterpret_cast<T*>(m_file->GetData() + m_headerSize);
+				m_size = count;
+				return;
+			}
+		}
+
+		m_heap.resize(count);
+		m_data = m_heap.data();
+		m_size = count;
+	}
+
+	std::vector<T> m_heap;
+	std::unique_ptr<MappedFile> m_file;
+	std::string m_path;
+	size_t m_headerSize;
+	T* m_data;
+	size_t m_size;
+};
@@ -0,0 +1,128 @@
+#include "ReferenceOrbit.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	// Bounds the reference magnitude so the 32-bit integer part of the fixed-point type never overflows
+	const double s_maxReferenceBailout = 1048576.0;
+}
+
+ReferenceOrbit::ReferenceOrbit()
+	: m_center()
+	, m_maxIterations(0)
+	, m_bailout(0.0)
+	, m_precisionBits(0)
+	, m_valid(false)
+{
+}
+
+bool ReferenceOrbit::Compute(const math::vec2<math::deepfixed>& center, double zoom, int height, int maxIterations, double bailout, const std::atomic<bool>& cancelRequested)
+{
+	m_valid = false;
+	m_center = center;
+	m_maxIterations = maxIterations;
+	m_bailout = bailout;
+
+	const double referenceBailout = std::min(bailout, s_maxReferenceBailout);
+	const size_t bits = GetRequiredFractionBits(zoom, height);
+
+	bool completed = false;
+	if (bits <= math::fixedpoint<4>::fractionBits)
+	{
+		completed = Iterate<4>(center, maxIterations, referenceBailout, cancelRequested);
+	}
+	else if (bits <= math::fixedpoint<8>::fractionBits)
+	{
+		completed = Iterate<8>(center, maxIterations, referenceBailout, cancelRequested);
+	}
+	else
+	{
+		completed = Iterate<math::deepfixed::fractionLimbs>(center, maxIterations, referenceBailout, cancelRequested);
+	}
+
+	m_valid = completed;
+	return completed;
+}
+
+template<size_t Limbs>
+bool ReferenceOrbit::Iterate(const math::vec2<math::deepfixed>& center, int maxIterations, double bailout, const std::atomic<bool>& cancelRequested)
+{
+	using real = math::fixedpoint<Limbs>;
+
+	m_precisionBits = real::fractionBits;
+	m_points.clear();
+	m_points.reserve(static_cast<size_t>(maxIterations) + 2);
+
+	const math::vec2<real> c(real(center.x), real(center.y));
+	math::vec2<real> z;
+	m_points.push_back(math::vec2d());
+
+	for (int i = 0; i <= maxIterations; ++i)
+	{
+		if ((i & 1023) == 0 && cancelRequested.load(std::memory_order_relaxed))
+			return false;
+
+		// Z -> Z^2 + C
+		const real xy = z.x * z.y;
+		z = math::vec2<real>(z.x * z.x - z.y * z.y + c.x, xy + xy + c.y);
+
+		const math::vec2d point(z.x.toDouble(), z.y.toDouble());
+		m_points.push_back(point);
+
+		if (math::dot(point, point) > bailout)
+			break;
+	}
+	return true;
+}
+
+bool ReferenceOrbit::IsReusable(const math::vec2<math::deepfixed>& center, double zoom, int height, int maxIterations, double bailout) const
+{
+	// the orbit does not depend on the zoom, only its precision does: a deeper one serves shallower views
+	if (!m_valid || m_precisionBits < GetRequiredFractionBits(zoom, height) || m_maxIterations != maxIterations || m_bailout != bailout)
+		return false;
+
+	// keep the reference while it stays within a couple of view heights from the new center
+	const double distanceX = (center.x - m_center.x).toDouble();
+	const double distanceY = (center.y - m_center.y).toDouble();
+	const double viewHeight = 2.0 / zoom;
+	return std::fabs(distanceX) < 2.0 * viewHeight && std::fabs(distanceY) < 2.0 * viewHeight;
+}
+
+void ReferenceOrbit::Invalidate()
+{
+	m_valid = false;
+}
+
+bool ReferenceOrbit::IsValid() const
+{
+	return m_valid;
+}
+
+const math::vec2d* ReferenceOrbit::GetPoints() const
+{
+	return m_points.data();
+}
+
+size_t ReferenceOrbit::GetLength() const
+{
+	return m_points.empty() ? 0 : m_points.size() - 1;
+}
+
+const math::vec2<math::deepfixed>& ReferenceOrbit::GetCenter() const
+{
+	return m_center;
+}
+
+size_t ReferenceOrbit::GetPrecisionBits() const
+{
+	return m_precisionBits;
+}
+
+size_t ReferenceOrbit::GetRequiredFractionBits(double zoom, int height)
+{
+	// pixel spacing is 2 / (zoom * height), keep 64 guard bits below it
+	const double pixelBits = std::log2(std::max(zoom, 1.0)) + std::log2(std::max(height, 1)) + 1.0;
+	return static_cast<size_t>(std::ceil(pixelBits)) + 64;
+}
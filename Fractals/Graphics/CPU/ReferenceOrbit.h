@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "Math/vec.h"
+#include "Math/fixedpoint.h"
+
+// High-precision orbit of a single reference point C, stored as doubles Z_0 = 0, Z_1, ... Z_length.
+// Pixels near C only iterate their low-precision delta from this orbit (see PerturbationKernels.h).
+class ReferenceOrbit
+{
+public:
+	ReferenceOrbit();
+
+	// Iterates Z -> Z^2 + C with enough fraction bits for `zoom`, stops when |Z|^2 exceeds `bailout`.
+	// Returns false when `cancelRequested` was raised, the orbit is invalid then.
+	bool Compute(const math::vec2<math::deepfixed>& center, double zoom, int height, int maxIterations, double bailout, const std::atomic<bool>& cancelRequested);
+
+	// True when the orbit was computed for these settings with enough precision for `zoom` and `center` is close enough to reuse it
+	bool IsReusable(const math::vec2<math::deepfixed>& center, double zoom, int height, int maxIterations, double bailout) const;
+
+	void Invalidate();
+
+	bool IsValid() const;
+	const math::vec2d* GetPoints() const;
+	size_t GetLength() const;
+
+	const math::vec2<math::deepfixed>& GetCenter() const;
+	size_t GetPrecisionBits() const;
+
+	static size_t GetRequiredFractionBits(double zoom, int height);
+
+private:
+	template<size_t Limbs>
+	bool Iterate(const math::vec2<math::deepfixed>& center, int maxIterations, double bailout, const std::atomic<bool>& cancelRequested);
+
+	std::vector<math::vec2d> m_points;
+
+	math::vec2<math::deepfixed> m_center;
+	int m_maxIterations;
+	double m_bailout;
+	size_t m_precisionBits;
+	bool m_valid;
+};
@@ -0,0 +1,100 @@
+#include "TileCache.h"
+
+#include <functional>
+
+const int TileCache::s_tileSize = 64;
+
+TileCache::TileCache()
+	: m_capacity(0)
+{
+}
+
+void TileCache::SetCapacity(size_t bytes)
+{
+	m_capacity = bytes;
+	Trim();
+}
+
+size_t TileCache::GetCapacity() const
+{
+	return m_capacity;
+}
+
+std::shared_ptr<const TileCache::Values> TileCache::Find(const CachedTileKey& key)
+{
+	const auto found = m_index.find(key);
+	if (found == m_index.end())
+	{
+		++m_stats.misses;
+		return nullptr;
+	}
+
+	++m_stats.hits;
+	m_entries.splice(m_entries.begin(), m_entries, found->second);
+	return found->second->values;
+}
+
+std::shared_ptr<const TileCache::Values> TileCache::Peek(const CachedTileKey& key) const
+{
+	const auto found = m_index.find(key);
+	return found != m_index.end() ? found->second->values : nullptr;
+}
+
+void TileCache::Store(const CachedTileKey& key, std::shared_ptr<const Values> values)
+{
+	const auto found = m_index.find(key);
+	if (found != m_index.end())
+	{
+		found->second->values = std::move(values);
+		m_entries.splice(m_entries.begin(), m_entries, found->second);
+		return;
+	}
+
+	m_entries.push_front(Entry{ key, std::move(values) });
+	m_index.emplace(key, m_entries.begin());
+	++m_stats.tiles;
+	m_stats.bytes += GetEntryBytes();
+	Trim();
+}
+
+void TileCache::Clear()
+{
+	m_entries.clear();
+	m_index.clear();
+	m_stats.tiles = 0;
+	m_stats.bytes = 0;
+}
+
+TileCacheStats TileCache::GetStats() const
+{
+	return m_stats;
+}
+
+void TileCache::Trim()
+{
+	while (!m_entries.empty() && m_stats.bytes > m_capacity)
+	{
+		m_index.erase(m_entries.back().key);
+		m_entries.pop_back();
+		--m_stats.tiles;
+		m_stats.bytes -= GetEntryBytes();
+		++m_stats.evictions;
+	}
+}
+
+size_t TileCache::GetEntryBytes()
+{
+	return static_cast<size_t>(s_tileSize) * s_tileSize * sizeof(float) + sizeof(Entry);
+}
+
+size_t TileCache::KeyHash::operator()(const CachedTileKey& key) const
+{
+	size_t hash = std::hash<int>()(key.level);
+	const auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2); };
+	combine(std::hash<int64_t>()(key.x));
+	combine(std::hash<int64_t>()(key.y));
+	combine(std::hash<int>()(key.maxIterations));
+	combine(std::hash<float>()(key.threshold));
+	combine(static_cast<size_t>(key.kind));
+	return hash;
+}
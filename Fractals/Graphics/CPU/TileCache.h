@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Kernel output stored by a tile
+enum class CachedTileKind
+{
+	SMOOTH_ITERATIONS,
+	DISTANCE,
+};
+
+// A square of TileCache::s_tileSize points on the grid of one level: point (i, j) of tile (x, y)
+// is c = 2^level * (x * s_tileSize + i, y * s_tileSize + j). The grid is anchored at c = 0, so the four
+// tiles covering a tile at the level below are its quadtree children.
+struct CachedTileKey
+{
+	int level;
+	int64_t x;
+	int64_t y;
+	int maxIterations;
+	float threshold;
+	CachedTileKind kind;
+
+	bool operator==(const CachedTileKey& rhs) const
+	{
+		return level == rhs.level && x == rhs.x && y == rhs.y
+			&& maxIterations == rhs.maxIterations && threshold == rhs.threshold && kind == rhs.kind;
+	}
+};
+
+struct TileCacheStats
+{
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+	size_t tiles = 0;
+	size_t bytes = 0;
+};
+
+// Least recently used cache of per-point kernel output as stored by the renderer, NaN where a point was not computed.
+// Evicts the oldest tiles once the stored values exceed the capacity. Not thread safe: it is used
+// by the thread that starts the render jobs, before and after the workers run.
+class TileCache
+{
+public:
+	static const int s_tileSize;
+
+	// s_tileSize * s_tileSize values, rows from the lowest y
+	using Values = std::vector<float>;
+
+	TileCache();
+
+	void SetCapacity(size_t bytes);
+	size_t GetCapacity() const;
+
+	// Counts a hit or a miss and marks the tile as recently used
+	std::shared_ptr<const Values> Find(const CachedTileKey& key);
+	// Same as Find without touching the statistics or the order
+	std::shared_ptr<const Values> Peek(const CachedTileKey& key) const;
+	void Store(const CachedTileKey& key, std::shared_ptr<const Values> values);
+
+	void Clear();
+
+	TileCacheStats GetStats() const;
+
+private:
+	struct Entry
+	{
+		CachedTileKey key;
+		std::shared_ptr<const Values> values;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const CachedTileKey& key) const;
+	};
+
+	void Trim();
+
+	static size_t GetEntryBytes();
+
+	// most recently used first
+	std::list<Entry> m_entries;
+	std::unordered_map<CachedTileKey, std::list<Entry>::iterator, KeyHash> m_index;
+
+	size_t m_capacity;
+	TileCacheStats m_stats;
+};
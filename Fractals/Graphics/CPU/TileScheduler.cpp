@@ -0,0 +1,56 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+
+TileScheduler::TileScheduler()
+	: m_width(0)
+	, m_height(0)
+	, m_tileSize(1)
+	, m_tilesX(0)
+	, m_tileCount(0)
+	, m_cursor(0)
+{
+}
+
+void TileScheduler::Reset(int width, int height, int tileSize)
+{
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_tileSize = std::max(tileSize, 1);
+	m_tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+	const int tilesY = (m_height + m_tileSize - 1) / m_tileSize;
+	m_tileCount = static_cast<size_t>(m_tilesX) * tilesY;
+	m_cursor.store(0, std::memory_order_relaxed);
+}
+
+bool TileScheduler::Next(RenderTile& tile)
+{
+	const size_t index = m_cursor.fetch_add(1, std::memory_order_relaxed);
+	if (index >= m_tileCount)
+	{
+		return false;
+	}
+	tile = GetTile(index);
+	return true;
+}
+
+RenderTile TileScheduler::GetTile(size_t index) const
+{
+	RenderTile tile;
+	tile.index = index;
+	tile.x = static_cast<int>(index % m_tilesX) * m_tileSize;
+	tile.y = static_cast<int>(index / m_tilesX) * m_tileSize;
+	tile.width = std::min(m_tileSize, m_width - tile.x);
+	tile.height = std::min(m_tileSize, m_height - tile.y);
+	return tile;
+}
+
+size_t TileScheduler::GetTileCount() const
+{
+	return m_tileCount;
+}
+
+int TileScheduler::GetTileSize() const
+{
+	return m_tileSize;
+}
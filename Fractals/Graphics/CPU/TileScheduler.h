@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+struct RenderTile
+{
+	size_t index;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+// Splits the frame into square tiles handed out in row-major order from a shared atomic cursor.
+// Workers keep taking tiles until the frame is exhausted, which balances cheap and expensive regions.
+class TileScheduler
+{
+public:
+	TileScheduler();
+
+	void Reset(int width, int height, int tileSize);
+
+	bool Next(RenderTile& tile);
+	RenderTile GetTile(size_t index) const;
+
+	size_t GetTileCount() const;
+	int GetTileSize() const;
+
+private:
+	int m_width;
+	int m_height;
+	int m_tileSize;
+	int m_tilesX;
+	size_t m_tileCount;
+
+	std::atomic<size_t> m_cursor;
+};
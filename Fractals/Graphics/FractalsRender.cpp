@@ -3,15 +3,22 @@
 #include "MandelbrotCPURender.h"
 
 #include "Logger/Logger.h"
+#include "Trace/Trace.h"
 
 #include "imgui.h"
 #include "UI/ToolsUI.h"
 
 #include "Data/RenderConfig.h"
+#include "Data/RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
 
 FractalsRender::FractalsRender()
 	: DataProvider<RenderConfig>(m_mandelbrotConfig)
+	, DataProvider<RenderStats>(m_renderStats)
 	, m_mandelbrotConfig(new RenderConfig())
+	, m_renderStats(new RenderStats())
 	, m_mandelbrotGPURender(new MandelbrotGPURender())
 	, m_mandelbrotCPURender(new MandelbrotCPURender())
 	, m_toolsUI(new ToolsUI())
@@ -20,15 +27,17 @@ FractalsRender::FractalsRender()
 
 FractalsRender::~FractalsRender()
 {
-	m_toolsUI->ResetBind();
+	m_toolsUI->DataBinder<RenderConfig>::ResetBind();
+	m_toolsUI->DataBinder<RenderStats>::ResetBind();
 	m_mandelbrotGPURender->ResetBind();
 }
 
 void FractalsRender::Init()
 {
-	ProvideData(*m_toolsUI);
-	ProvideData(*m_mandelbrotGPURender);
-	ProvideData(*m_mandelbrotCPURender);
+	DataProvider<RenderConfig>::ProvideData(*m_toolsUI);
+	DataProvider<RenderStats>::ProvideData(*m_toolsUI);
+	DataProvider<RenderConfig>::ProvideData(*m_mandelbrotGPURender);
+	DataProvider<RenderConfig>::ProvideData(*m_mandelbrotCPURender);
 	m_toolsUI->Reset();
 	m_mandelbrotGPURender->Init();
 }
@@ -46,7 +55,7 @@ void FractalsRender::OnRender()
 
 	if (m_mandelbrotConfig->m_useCPU)
 	{
-		m_mandelbrotCPURender->OnRender();
+		DrawCPUFrame();
 	}
 	else
 	{
@@ -54,6 +63,21 @@ void FractalsRender::OnRender()
 	}
 }
 
+void FractalsRender::DrawCPUFrame()
+{
+	// the CPU engine has no GL dependency, its frame is drawn here
+	if (const unsigned char* frame = m_mandelbrotCPURender->GetFrameData())
+	{
+		TraceScope trace("Upload frame");
+		const math::vec2i& size = m_mandelbrotCPURender->GetFrameSize();
+		glRasterPos2f(-1.f, -1.f);
+		glPixelStoref(GL_PACK_ALIGNMENT, 1);
+		glPixelStoref(GL_UNPACK_ALIGNMENT, 1);
+		glDrawPixels(size.width, size.height, GL_BGR, GL_UNSIGNED_BYTE, frame);
+		glFlush();
+	}
+}
+
 void FractalsRender::OnWindowSizeChanged(const math::vec2f& newSize)
 {
 	m_mandelbrotConfig->m_windowSize = newSize;
@@ -61,6 +85,11 @@ void FractalsRender::OnWindowSizeChanged(const math::vec2f& newSize)
 
 void FractalsRender::UpdateGUI()
 {
+	if (m_mandelbrotConfig->m_useCPU)
+	{
+		*m_renderStats = m_mandelbrotCPURender->GetRenderStats();
+	}
+
 	m_toolsUI->Update();
 
 	if (m_mandelbrotConfig->m_useCPU)
@@ -83,22 +112,21 @@ void FractalsRender::UpdateInput()
 		{
 			const ImVec2 dragDelta = ImGui::GetMouseDragDelta(0);
 			const math::vec2d windowScale(2. / m_mandelbrotConfig->m_windowSize.y, 2. / m_mandelbrotConfig->m_windowSize.y);
-			m_mandelbrotConfig->m_offset = math::vec2d(dragDelta.x, -dragDelta.y) * (1.0f / m_mandelbrotConfig->m_zoom) * windowScale;
+			m_mandelbrotConfig->m_offset = math::vec2d(dragDelta.x, -dragDelta.y) * (1.0 / m_mandelbrotConfig->m_zoom) * windowScale;
 		}
 		else
 		{
-			m_mandelbrotConfig->m_position += m_mandelbrotConfig->m_offset;
+			const math::vec2d& offset = m_mandelbrotConfig->m_offset;
+			m_mandelbrotConfig->m_position += offset;
+			m_mandelbrotConfig->m_deepPosition += math::vec2<math::deepfixed>(offset.x, offset.y);
 			m_mandelbrotConfig->m_offset = math::vec2d(.0, .0);
 		}
 
 		if (io.MouseWheel != 0.0f)
 		{
-			const float diff = m_mandelbrotConfig->m_zoom * 0.11f * io.MouseWheel; // add/subtract 11% of zoom
-			m_mandelbrotConfig->m_zoom += diff;
-			if (m_mandelbrotConfig->m_zoom < 1.0f)
-			{
-				m_mandelbrotConfig->m_zoom = 1.0f;
-			}
+			// multiplies/divides the zoom by 1.11 per notch, a fractional trackpad delta by that part of a notch.
+			// The tile cache rounds the pixel size to its own levels, the zoom is not rounded here
+			m_mandelbrotConfig->m_zoom = std::max(m_mandelbrotConfig->m_zoom * std::pow(1.11, static_cast<double>(io.MouseWheel)), 1.0);
 		}
 	}
 }
@@ -7,8 +7,9 @@ class MandelbrotGPURender;
 class MandelbrotCPURender;
 class ToolsUI;
 struct RenderConfig;
+struct RenderStats;
 
-class FractalsRender : public DataProvider<RenderConfig>
+class FractalsRender : public DataProvider<RenderConfig>, public DataProvider<RenderStats>
 {
 public:
 
@@ -25,8 +26,11 @@ public:
 private:
 	void UpdateGUI();
 	void UpdateInput();
+	void DrawCPUFrame();
 
 	std::shared_ptr<RenderConfig> m_mandelbrotConfig;
+	// copy of the CPU render statistics, refreshed every frame for the tools window
+	std::shared_ptr<RenderStats> m_renderStats;
 	std::unique_ptr<MandelbrotGPURender> m_mandelbrotGPURender;
 	std::unique_ptr<MandelbrotCPURender> m_mandelbrotCPURender;
 
@@ -3,27 +3,81 @@
 #include <stdexcept>
 #include <cmath>
 #include <algorithm>
-#include <gl/glew.h>
+#include <numeric>
+#include <iterator>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <numbers>
 
 #include "Palette.h"
+#include "Math/fastmath.h"
+#include "CPU/PerturbationKernels.h"
+#include "Logger/Logger.h"
+#include "Trace/Trace.h"
 
 const size_t MandelbrotCPURender::s_sizeofRGB = 3;
-const size_t MandelbrotCPURender::s_offesetR = 0;
+// BGR, the pixel order of BMP files
+const size_t MandelbrotCPURender::s_offesetR = 2;
 const size_t MandelbrotCPURender::s_offesetG = 1;
-const size_t MandelbrotCPURender::s_offesetB = 2;
+const size_t MandelbrotCPURender::s_offesetB = 0;
+const size_t MandelbrotCPURender::s_bmpHeaderSize = 54;
+const size_t MandelbrotCPURender::s_pfmHeaderSize = 32;
+// periodicity tolerance relative to the pixel size: small enough that slowly escaping boundary points are not caught
+const double MandelbrotCPURender::s_periodicityPixelFraction = 1e-3;
+const int MandelbrotCPURender::s_rectTileSize = 64;
+const int MandelbrotCPURender::s_progressiveFirstStep = 8;
+const int MandelbrotCPURender::s_marianiSilverMinSize = 6;
+// sub-samples of a pixel fit the byte of m_pixelSamples with the pixel point
+const int MandelbrotCPURender::s_maxSubsamples = 64;
+// sub-samples every refined pixel gets, the rest only where these still disagree
+const int MandelbrotCPURender::s_firstSubsamples = 4;
+// sharp differences: two palette entries in color mode, 1/16 of the gray range in the gray mode
+const float MandelbrotCPURender::s_iterationContrast = 2.0f;
+const float MandelbrotCPURender::s_grayContrast = 1.0f / 16.0f;
 
-MandelbrotCPURender::MandelbrotCPURender()
-	: m_isBusy(false)
+MandelbrotCPURender::MandelbrotCPURender(size_t threadCount)
+	: MandelbrotCPURender(threadCount, kernels::SelectKernelSet())
+{
+}
+
+MandelbrotCPURender::MandelbrotCPURender(size_t threadCount, const kernels::KernelSet& kernels)
+	: m_threadPool(new ThreadPool(threadCount))
+	, m_renderTasks(new TaskGroup(*m_threadPool))
 	, m_cancelRequested(false)
+	, m_reportPending(false)
+	, m_firstPixelTime(-1.0)
+	, m_drawMode(DrawMode::ROWS)
+	, m_zoomRatio(0.0)
+	, m_keptPixels(0)
+	, m_progressiveStep(1)
+	, m_passWorkersLeft(0)
+	, m_recoloredPixels(0)
+	, m_supersamplePass(false)
+	, m_supersampleStart(0.0)
+	, m_refinedPixels(0)
+	, m_subsamples(0)
+	, m_cacheGrid()
+	, m_cacheHits(0)
+	, m_cacheMisses(0)
+	, m_cachedPixels(0)
+	, m_cacheStorePending(false)
+	, m_referenceTime(0.0)
+	, m_blaTime(0.0)
+	, m_referenceReused(false)
+	, m_blaReused(false)
+	, m_deepestZoom(0.0)
 	, m_sizeData(0)
 	, m_maxSizeData(0)
+	, m_kernels(kernels)
 {
-
+	Logger::Log(LogLevel::INFO, std::string("CPU render kernels: ") + m_kernels.name);
+	Logger::Log(LogLevel::INFO, "CPU render threads: " + std::to_string(m_threadPool->GetThreadCount()));
 }
 
 MandelbrotCPURender::~MandelbrotCPURender()
 {
-	if (m_isBusy.load(std::memory_order_relaxed) || m_mainThread.joinable())
+	if (IsBusy())
 	{
 		StopMainWorker();
 		CleanupMainWorker();
@@ -36,12 +90,15 @@ void MandelbrotCPURender::OnUpdate()
 	{
 		if (m_prevConfig != *config)
 		{
+			TraceScope trace("Config change");
 			m_prevConfig = *config;
 			if (IsBusy())
 			{
+				TraceScope cancelTrace("Cancel job");
 				StopMainWorker();
 				CleanupMainWorker();
 			}
+			StoreToTileCache();
 
 			if (config->m_useCPU)
 			{
@@ -50,260 +107,1607 @@ void MandelbrotCPURender::OnUpdate()
 		}
 	}
 
-	if (!m_isBusy.load(std::memory_order_relaxed) && m_mainThread.joinable())
+	FinishJob();
+}
+
+void MandelbrotCPURender::FinishJob()
+{
+	if (m_reportPending && !IsBusy())
 	{
-		CleanupMainWorker();
+		TraceScope trace("Finish job");
+		m_reportPending = false;
+		StoreToTileCache();
+		ReportTimings();
 	}
 }
 
-void MandelbrotCPURender::OnRender()
+bool MandelbrotCPURender::IsBusy() const
+{
+	return !m_renderTasks->IsDone();
+}
+
+void MandelbrotCPURender::Wait()
+{
+	m_renderTasks->Wait();
+	FinishJob();
+}
+
+const unsigned char* MandelbrotCPURender::GetFrameData() const
+{
+	return m_bufferData.data();
+}
+
+const math::vec2i& MandelbrotCPURender::GetFrameSize() const
+{
+	return m_currentResolution;
+}
+
+const float* MandelbrotCPURender::GetPixelValues() const
+{
+	return m_pixelValues.empty() ? nullptr : m_pixelValues.data();
+}
+
+kernels::EscapeStats MandelbrotCPURender::GetKernelStats() const
 {
-	if (m_bufferData)
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	kernels::EscapeStats total;
+	for (const kernels::EscapeStats& stats : m_workerStats)
 	{
-		glRasterPos2f(-1.f, -1.f);
-		glPixelStoref(GL_PACK_ALIGNMENT, 1);
-		glPixelStoref(GL_UNPACK_ALIGNMENT, 1);
-		glDrawPixels(m_currentResolution.width, m_currentResolution.height, GL_RGB, GL_UNSIGNED_BYTE, m_bufferData.get());
-		glFlush();
+		total += stats;
 	}
+	return total;
 }
 
-bool MandelbrotCPURender::IsBusy() const
+RenderStats MandelbrotCPURender::GetRenderStats() const
+{
+	RenderStats stats;
+	if (m_workerBusyTimes.empty())
+		return stats;
+
+	// checked first: once the job is done, the counters read below are final
+	stats.m_finished = !IsBusy();
+	stats.m_resolution = m_currentResolution;
+
+	const kernels::EscapeStats kernelStats = GetKernelStats();
+	stats.m_iterations = kernelStats.iterations;
+	stats.m_bulbPixels = kernelStats.bulbPoints;
+	stats.m_maxIterationPixels = kernelStats.maxIterationPoints;
+	stats.m_periodicPixels = kernelStats.periodicPoints;
+
+	// the cache is used by the thread starting the jobs, the one reading the statistics
+	const TileCacheStats cacheStats = m_tileCache.GetStats();
+	stats.m_cacheHits = m_cacheHits;
+	stats.m_cacheMisses = m_cacheMisses;
+	stats.m_cachedPixels = m_cachedPixels;
+	stats.m_cacheTiles = cacheStats.tiles;
+	stats.m_cacheBytes = cacheStats.bytes;
+
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	stats.m_refinedPixels = m_refinedPixels;
+	stats.m_subsamples = m_subsamples;
+	stats.m_workerBusyTimes = m_workerBusyTimes;
+	stats.m_firstPixelTime = m_firstPixelTime;
+	stats.m_elapsedTime = stats.m_finished ? *std::max_element(m_workerFinishTimes.begin(), m_workerFinishTimes.end())
+		: std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_jobStart).count();
+	return stats;
+}
+
+void MandelbrotCPURender::SetMappedStorage(const std::string& framePath, const std::string& valuesPath)
 {
-	return m_mainThread.joinable() || m_isBusy.load(std::memory_order_relaxed);
+	m_bufferData.SetMappedFile(framePath, s_bmpHeaderSize);
+	m_pixelValues.SetMappedFile(valuesPath, s_pfmHeaderSize);
+	m_otherValues.SetMappedFile(std::string(), 0);
+
+	// the next job starts from empty buffers
+	m_maxSizeData = 0;
+	m_currentResolution = math::vec2i(0, 0);
+}
+
+bool MandelbrotCPURender::IsFrameMapped() const
+{
+	return m_bufferData.IsMapped();
+}
+
+void MandelbrotCPURender::SetDeepestZoom(double zoom)
+{
+	m_deepestZoom = zoom;
 }
 
 void MandelbrotCPURender::StartMainWorker()
 {
 	if (std::shared_ptr<RenderConfig> config = GetData())
 	{
+		TraceScope trace("Start job");
 		int width = static_cast<int>(config->m_windowSize.width);
 		int height = static_cast<int>(config->m_windowSize.height);
+		if (!m_bufferData.GetMappedPath().empty() && (s_sizeofRGB * width) % 4 != 0)
+		{
+			// BMP rows are padded to 4 bytes while the workers write them back to back
+			Logger::Log(LogLevel::ERR, "CPU mapped storage: " + m_bufferData.GetMappedPath() + " needs a width that is a multiple of 4, the frame is kept in memory");
+			m_bufferData.SetMappedFile(std::string(), 0);
+			m_maxSizeData = 0;
+			m_currentResolution = math::vec2i(0, 0);
+		}
+		const bool sameResolution = m_currentResolution.width == width && m_currentResolution.height == height;
+
+		// the CPU path draws the drag offset too, which turns dragging into a series of pans
+		RenderConfig jobConfig = *config;
+		jobConfig.m_position = config->m_position + config->m_offset;
+		jobConfig.m_deepPosition += math::vec2<math::deepfixed>(config->m_offset.x, config->m_offset.y);
+		jobConfig.m_offset = math::vec2d(0.0, 0.0);
+
+		m_tileCache.SetCapacity(static_cast<size_t>(std::max(jobConfig.m_tileCacheSize, 0)) << 20);
+
+		m_panShift = math::vec2i(0, 0);
+		const bool panned = sameResolution && !m_bufferData.empty() && FindPanShift(jobConfig, m_panShift);
+		if (panned)
+		{
+			// the view moves by whole pixels, the sub-pixel rest of the pan waits for the next change
+			const double pixelSize = 2.0 / (jobConfig.m_zoom * height);
+			const math::vec2d delta(m_panShift.x * pixelSize, m_panShift.y * pixelSize);
+			jobConfig.m_position = m_jobConfig.m_position + delta;
+			jobConfig.m_deepPosition = m_jobConfig.m_deepPosition + math::vec2<math::deepfixed>(delta.x, delta.y);
+		}
+
+		// a color mode or palette change keeps the view, only the coloring runs again over the stored values
+		const bool recolored = !panned && sameResolution && !m_bufferData.empty() && IsPresentationChange(jobConfig);
+		if (recolored)
+		{
+			jobConfig.m_position = m_jobConfig.m_position;
+			jobConfig.m_deepPosition = m_jobConfig.m_deepPosition;
+		}
+
+		// a zoom step shows the previous frame resampled to the new view until the workers draw over it
+		const bool zoomed = !panned && !recolored && sameResolution && !m_bufferData.empty() && IsZoomChange(jobConfig);
+
+		// any zoom and frame size maps to a level of the cache, pixels take the nearest point of its grid
+		CacheGrid cacheGrid = CacheGrid();
+		if (UseTileCache(jobConfig))
+		{
+			MakeCacheGrid(jobConfig, math::vec2i(width, height), cacheGrid);
+		}
+
 		m_sizeData = s_sizeofRGB * width * height;
-		if (m_maxSizeData < m_sizeData)
+		// a mapped frame is the whole file, so it follows the frame size
+		if (m_maxSizeData < m_sizeData || (m_bufferData.IsMapped() && m_maxSizeData != m_sizeData))
 		{
 			MakeBufferData(m_sizeData);
 		}
-		else
+		else if (panned)
+		{
+			ShiftPixels(m_bufferData.data(), m_currentResolution, s_sizeofRGB, m_panShift, 0);
+		}
+		else if (zoomed || recolored)
+		{
+			// the preview is written together with the values below, or the frame is colored over
+		}
+		else if (!config->m_progressiveEnabled || !sameResolution)
 		{
-			std::memset(m_bufferData.get(), 0, m_sizeData);
+			// progressive passes keep the previous frame on screen until the first pass covers it
+			std::memset(m_bufferData.data(), 0, m_sizeData);
 		}
 		m_currentResolution.width = width;
 		m_currentResolution.height = height;
 
+		// all bits set is a NaN: pixels without a value are the ones still to compute
+		const size_t pixelCount = static_cast<size_t>(width) * height;
+		m_keptPixels = 0;
+		if (panned)
+		{
+			ShiftPixels(reinterpret_cast<unsigned char*>(m_pixelValues.data()), m_currentResolution, sizeof(float), m_panShift, 0xFF);
+		}
+		else if (zoomed)
+		{
+			m_keptPixels = ReprojectFrame(jobConfig, cacheGrid);
+		}
+		else if (recolored)
+		{
+			if (jobConfig.m_colorEnabled != m_jobConfig.m_colorEnabled)
+			{
+				// each color mode has its own plane: the other one is reused when it was computed for this view
+				const bool otherValid = m_otherValues.size() == pixelCount && IsSameView(m_otherValuesConfig, m_jobConfig);
+				std::swap(m_pixelValues, m_otherValues);
+				m_otherValuesConfig = m_jobConfig;
+				if (!otherValid)
+				{
+					m_pixelValues.assign(pixelCount, std::numeric_limits<float>::quiet_NaN());
+				}
+			}
+		}
+		else
+		{
+			m_pixelValues.assign(pixelCount, std::numeric_limits<float>::quiet_NaN());
+		}
+		// colors kept by a pan keep their sub-samples, all others are checked again by the supersampling pass
+		if (panned)
+		{
+			ShiftPixels(m_pixelSamples.data(), m_currentResolution, 1, m_panShift, 0);
+		}
+		else
+		{
+			m_pixelSamples.assign(pixelCount, 0);
+		}
+		WriteMappedHeaders();
+		m_recoloredPixels = recolored ? static_cast<size_t>(std::count_if(m_pixelValues.begin(), m_pixelValues.end(), [](float value) { return !std::isnan(value); })) : 0;
+		m_zoomRatio = zoomed ? jobConfig.m_zoom / m_jobConfig.m_zoom : 0.0;
+
 		m_cancelRequested.store(false, std::memory_order_relaxed);
-		m_mainThread = std::thread(&MandelbrotCPURender::MainWorker, this, *config);
-		m_isBusy.store(true, std::memory_order_relaxed);
+		m_jobConfig = jobConfig;
+		m_cacheGrid = std::move(cacheGrid);
+		FillFromTileCache();
+		m_cacheStorePending = !m_cacheGrid.columns.empty();
+		m_drawMode = m_recoloredPixels > 0 ? DrawMode::RECOLOR
+			: panned || m_keptPixels > 0 || m_cachedPixels > 0 ? DrawMode::MISSING_PIXELS
+			: m_jobConfig.m_progressiveEnabled ? DrawMode::PROGRESSIVE
+			: m_jobConfig.m_marianiSilverEnabled ? DrawMode::MARIANI_SILVER
+			: DrawMode::ROWS;
+
+		const int threadCount = static_cast<int>(m_threadPool->GetThreadCount());
+
+		// tile size 0 keeps the interleaved rows scheme, every row is then timed as one unit
+		const int tileSize = GetTileSize(m_jobConfig);
+		const bool useTiles = tileSize > 0;
+		m_tileScheduler.Reset(width, height, useTiles ? tileSize : 1);
+		m_tileTimes.assign(useTiles ? m_tileScheduler.GetTileCount() : static_cast<size_t>(height), 0.0);
+		{
+			std::lock_guard<std::mutex> lock(m_statsMutex);
+			m_workerBusyTimes.assign(threadCount, 0.0);
+			m_workerFinishTimes.assign(threadCount, 0.0);
+			m_workerStats.assign(threadCount, kernels::EscapeStats());
+			m_firstPixelTime = -1.0;
+			m_refinedPixels = 0;
+			m_subsamples = 0;
+		}
+		m_passTimes.clear();
+		m_supersamplePass = false;
+		m_progressiveStep = m_drawMode == DrawMode::PROGRESSIVE ? s_progressiveFirstStep : 1;
+		m_jobStart = std::chrono::steady_clock::now();
+		m_reportPending = true;
+
+		if (UsePerturbation(m_jobConfig))
+		{
+			// the reference orbit is needed by every pixel, workers are started once it is ready
+			m_renderTasks->Run([this]()
+			{
+				PrepareReferenceOrbit();
+				if (m_referenceOrbit.IsValid())
+				{
+					SubmitWorkers();
+				}
+			});
+		}
+		else
+		{
+			SubmitWorkers();
+		}
 	}
 }
 
-void MandelbrotCPURender::StopMainWorker()
+void MandelbrotCPURender::SubmitWorkers()
 {
-	m_cancelRequested.store(true, std::memory_order_relaxed);
+	const int threadCount = static_cast<int>(m_threadPool->GetThreadCount());
+	m_passWorkersLeft.store(threadCount, std::memory_order_relaxed);
+	for (int i = 0; i < threadCount; ++i)
+	{
+		m_renderTasks->Run([this, i, threadCount]() { WorkerDraw(m_jobConfig, i, threadCount); });
+	}
 }
 
-void MandelbrotCPURender::CleanupMainWorker()
+void MandelbrotCPURender::PrepareReferenceOrbit()
 {
-	if (m_mainThread.joinable())
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start = Clock::now();
+
+	// m_deepPosition is the negated view center, same as m_position
+	const math::vec2<math::deepfixed> center(-m_jobConfig.m_deepPosition.x, -m_jobConfig.m_deepPosition.y);
+	const double zoom = m_jobConfig.m_zoom;
+	const int maxIterations = m_jobConfig.m_maxIterations;
+	const double bailout = m_jobConfig.m_threshold;
+
+	const int height = static_cast<int>(std::ceil(GetEquivalentHeight(m_jobConfig)));
+
+	m_referenceReused = m_referenceOrbit.IsReusable(center, zoom, height, maxIterations, bailout);
+	if (!m_referenceReused)
 	{
-		m_mainThread.join();
+		m_referenceOrbit.Compute(center, std::max(zoom, m_deepestZoom), height, maxIterations, bailout, m_cancelRequested);
 	}
-	m_cancelRequested.store(false, std::memory_order_relaxed);
-	m_isBusy.store(false, std::memory_order_relaxed);
+
+	const math::vec2<math::deepfixed>& reference = m_referenceOrbit.GetCenter();
+	m_referenceOffset = math::vec2d((reference.x - center.x).toDouble(), (reference.y - center.y).toDouble());
+	const Clock::time_point referenceEnd = Clock::now();
+	m_referenceTime = std::chrono::duration<double, std::milli>(referenceEnd - start).count();
+	Trace::Complete(m_referenceReused ? "Reference orbit (reused)" : "Reference orbit", start, referenceEnd, "iterations", static_cast<int64_t>(m_referenceOrbit.GetLength()));
+
+	// largest pixel delta: half of the view diagonal plus the distance to the reference point,
+	// which also bounds the outer radius 1 / zoom of an exponential map
+	const double scale = 1.0 / zoom;
+	const double aspect = static_cast<double>(m_currentResolution.width) / m_currentResolution.height;
+	const double maxDelta = scale * std::sqrt(aspect * aspect + 1.0) + std::sqrt(math::dot(m_referenceOffset, m_referenceOffset));
+
+	// the table of the same orbit built for a view up to twice as large still holds and skips nearly as far
+	const bool useBLA = m_jobConfig.m_blaEnabled && m_referenceOrbit.IsValid();
+	m_blaReused = useBLA && m_referenceReused && m_blaTable.GetLevelCount() > 0
+		&& m_blaTable.GetMaxDelta() >= maxDelta && m_blaTable.GetMaxDelta() <= 2.0 * maxDelta;
+	m_blaTime = 0.0;
+	if (m_blaReused)
+		return;
+
+	m_blaTable.Clear();
+	if (useBLA)
+	{
+		const Clock::time_point blaStart = Clock::now();
+		m_blaTable.Build(m_referenceOrbit, maxDelta);
+		const Clock::time_point blaEnd = Clock::now();
+		m_blaTime = std::chrono::duration<double, std::milli>(blaEnd - blaStart).count();
+		Trace::Complete("BLA table", blaStart, blaEnd);
+	}
+}
+
+bool MandelbrotCPURender::UseTileCache(const RenderConfig& refConfig) const
+{
+	// deep engines would need grid indices beyond 64 bits, an exponential map has no grid;
+	// the double view has exact grid indices down to pixel sizes of 2^-51
+	return refConfig.m_tileCacheSize > 0 && refConfig.m_cpuEngine == CPUEngine::STANDARD && !refConfig.m_exponentialMap
+		&& refConfig.m_zoom * refConfig.m_windowSize.height < std::ldexp(1.0, 52);
 }
 
-void MandelbrotCPURender::MainWorker(const RenderConfig copyConfig)
+void MandelbrotCPURender::MakeCacheGrid(const RenderConfig& refConfig, const math::vec2i& resolution, CacheGrid& outGrid)
 {
-	const int maxThread = std::thread::hardware_concurrency() - 1;
-	std::vector<std::thread> poolThread;
-	if (copyConfig.m_colorEnabled)
+	// the largest power of two not above the pixel size: every pixel gets a grid point of its own
+	const double pixelSize = 2.0 / (refConfig.m_zoom * resolution.height);
+	outGrid.level = std::ilogb(pixelSize);
+	const double gridSize = std::ldexp(1.0, outGrid.level);
+
+	// same mapping as FillSpanCoordinates, then the nearest grid point
+	const double scale = 1.0 / refConfig.m_zoom;
+	outGrid.columns.resize(resolution.width);
+	for (int x = 0; x < resolution.width; ++x)
 	{
-		for (int i = 0; i < maxThread; ++i)
-		{
-			poolThread.emplace_back(std::thread(&MandelbrotCPURender::WorkerColorDraw, this, std::ref(copyConfig), i, maxThread));
-		}
+		outGrid.columns[x] = std::llround((scale * (2.0 * x - resolution.width) / resolution.height - refConfig.m_position.x) / gridSize);
 	}
-	else
+	outGrid.rows.resize(resolution.height);
+	for (int y = 0; y < resolution.height; ++y)
 	{
-		for (int i = 0; i < maxThread; ++i)
-		{
-			poolThread.emplace_back(std::thread(&MandelbrotCPURender::WorkerGrayDraw, this, std::ref(copyConfig), i, maxThread));
-		}
+		outGrid.rows[y] = std::llround((scale * (2.0 * y - resolution.height) / resolution.height - refConfig.m_position.y) / gridSize);
 	}
-	for (std::thread& th : poolThread)
+}
+
+std::vector<MandelbrotCPURender::CacheTileRun> MandelbrotCPURender::GetCacheTileRuns(const std::vector<int64_t>& indices)
+{
+	// the indices grow with the pixel, so the pixels of one tile are consecutive
+	const auto floorDiv = [](int64_t value, int64_t divisor) { return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor); };
+	std::vector<CacheTileRun> runs;
+	for (int i = 0; i < static_cast<int>(indices.size()); ++i)
 	{
-		th.join();
+		const int64_t tile = floorDiv(indices[i], TileCache::s_tileSize);
+		if (runs.empty() || runs.back().tile != tile)
+		{
+			runs.push_back(CacheTileRun{ tile, i, i });
+		}
+		runs.back().end = i + 1;
 	}
-	poolThread.clear();
-	m_isBusy.store(false, std::memory_order_relaxed);
+	return runs;
 }
 
-void MandelbrotCPURender::WorkerColorDraw(const RenderConfig& refConfig, const int workerID, const int threadCount)
+CachedTileKey MandelbrotCPURender::MakeCacheKey(const int64_t tileX, const int64_t tileY) const
 {
-	const double scale = 1.0 / refConfig.m_zoom;
-	const size_t width = static_cast<unsigned long long>(refConfig.m_windowSize.width);
-	const size_t height = static_cast<unsigned long long>(refConfig.m_windowSize.height);
-	const math::vec2d resolution = math::toVec2d(refConfig.m_windowSize);
-	const math::vec2d position = refConfig.m_position;
-	const float threshold = refConfig.m_threshold;
-	const float logthreshold = std::log(threshold);
-	const int maxIterations = refConfig.m_maxIterations;
-
-	bool canceled = false;
-
-	for (size_t y = workerID; y < height; y += threadCount)
-	{
-		if (canceled = m_cancelRequested.load(std::memory_order_relaxed))
-			break;
+	CachedTileKey key;
+	key.level = m_cacheGrid.level;
+	key.x = tileX;
+	key.y = tileY;
+	key.maxIterations = m_jobConfig.m_maxIterations;
+	key.threshold = m_jobConfig.m_threshold;
+	key.kind = m_jobConfig.m_colorEnabled ? CachedTileKind::SMOOTH_ITERATIONS : CachedTileKind::DISTANCE;
+	return key;
+}
 
-		for (size_t x = 0; x < width; ++x)
-		{
-			math::vec2d coord(static_cast<double>(x), static_cast<double>(y));
+float MandelbrotCPURender::GetCacheValueScale() const
+{
+	// stored distances are in pixels, the pixel size of a frame is 1 to 2 grid spacings
+	if (m_jobConfig.m_colorEnabled)
+		return 1.0f;
+	return static_cast<float>(MakeDrawContext(m_jobConfig).pixelSize / std::ldexp(1.0, m_cacheGrid.level));
+}
 
-			math::vec2d c = scale * (2. * coord - resolution) / resolution.y - position;
-			math::vec2d z;
+void MandelbrotCPURender::FillFromTileCache()
+{
+	m_cacheHits = 0;
+	m_cacheMisses = 0;
+	m_cachedPixels = 0;
+	if (m_cacheGrid.columns.empty())
+		return;
 
-			double iterations = 0;
-			double lastDotProduct = 0;
+	const int tileSize = TileCache::s_tileSize;
+	const int width = m_currentResolution.width;
+	const std::vector<CacheTileRun> columnRuns = GetCacheTileRuns(m_cacheGrid.columns);
+	const std::vector<CacheTileRun> rowRuns = GetCacheTileRuns(m_cacheGrid.rows);
+	const float valueScale = 1.0f / GetCacheValueScale();
+	const TileCacheStats before = m_tileCache.GetStats();
 
-			const double c2 = math::dot(c, c);
-			// skip computation inside M1 - http://iquilezles.org/www/articles/mset_1bulb/mset1bulb.htm
-			if ((256.0 * c2 * c2 - 96.0 * c2 + 32.0 * c.x - 3.0 < 0.0)
-				// skip computation inside M2 - http://iquilezles.org/www/articles/mset_2bulb/mset2bulb.htm
-				|| (16.0 * (c2 + 2.0 * c.x + 1.0) - 1.0 < 0.0))
+	const DrawContext context = MakeDrawContext(m_jobConfig);
+	for (const CacheTileRun& rowRun : rowRuns)
+	{
+		for (const CacheTileRun& columnRun : columnRuns)
+		{
+			// only tiles with pixels left to compute are looked up, e.g. after a pan most are on screen already
+			bool missing = false;
+			for (int y = rowRun.first; y < rowRun.end && !missing; ++y)
 			{
-				iterations = 0.;
+				const float* values = &m_pixelValues[static_cast<size_t>(y) * width];
+				missing = std::any_of(values + columnRun.first, values + columnRun.end, [](float value) { return std::isnan(value); });
 			}
-			else
+			if (!missing)
+				continue;
+
+			const std::shared_ptr<const TileCache::Values> cached = m_tileCache.Find(MakeCacheKey(columnRun.tile, rowRun.tile));
+			if (!cached)
+				continue;
+
+			// a frame finer than the grid spacing skips some of its points, this is the resampling to the frame
+			for (int y = rowRun.first; y < rowRun.end; ++y)
 			{
-				while (iterations <= maxIterations)
+				const float* source = &(*cached)[static_cast<size_t>(m_cacheGrid.rows[y] - rowRun.tile * tileSize) * tileSize];
+				for (int x = columnRun.first; x < columnRun.end; ++x)
 				{
-					// Z -> Z + c
-					z = math::vec2d(z.x * z.x - z.y * z.y + c.x, 2 * z.x * z.y + c.y);
-					//
+					const size_t pixel = static_cast<size_t>(x) + static_cast<size_t>(y) * width;
+					const float value = source[m_cacheGrid.columns[x] - columnRun.tile * tileSize];
+					if (std::isnan(m_pixelValues[pixel]) && !std::isnan(value))
+					{
+						m_pixelValues[pixel] = value * valueScale;
+						WriteColor(context, pixel * s_sizeofRGB, m_pixelValues[pixel]);
+						++m_cachedPixels;
+					}
+				}
+			}
+		}
+	}
+
+	const TileCacheStats after = m_tileCache.GetStats();
+	m_cacheHits = after.hits - before.hits;
+	m_cacheMisses = after.misses - before.misses;
+}
+
+void MandelbrotCPURender::StoreToTileCache()
+{
+	if (!m_cacheStorePending)
+		return;
+	m_cacheStorePending = false;
+
+	const int tileSize = TileCache::s_tileSize;
+	const int width = m_currentResolution.width;
+	const std::vector<CacheTileRun> columnRuns = GetCacheTileRuns(m_cacheGrid.columns);
+	const std::vector<CacheTileRun> rowRuns = GetCacheTileRuns(m_cacheGrid.rows);
+	const float valueScale = GetCacheValueScale();
 
-					lastDotProduct = math::dot(z, z);
-					if (lastDotProduct > threshold)
-						break;
+	for (const CacheTileRun& rowRun : rowRuns)
+	{
+		for (const CacheTileRun& columnRun : columnRuns)
+		{
+			// merged with the cached tile: a frame may cover only a part of it, or be canceled before it was done.
+			// A grid point has a single value, the ones already cached are kept as they are
+			const CachedTileKey key = MakeCacheKey(columnRun.tile, rowRun.tile);
+			const std::shared_ptr<const TileCache::Values> cached = m_tileCache.Peek(key);
+			std::shared_ptr<TileCache::Values> merged = cached
+				? std::make_shared<TileCache::Values>(*cached)
+				: std::make_shared<TileCache::Values>(static_cast<size_t>(tileSize) * tileSize, std::numeric_limits<float>::quiet_NaN());
 
-					++iterations;
+			bool changed = false;
+			for (int y = rowRun.first; y < rowRun.end; ++y)
+			{
+				float* target = &(*merged)[static_cast<size_t>(m_cacheGrid.rows[y] - rowRun.tile * tileSize) * tileSize];
+				const float* values = &m_pixelValues[static_cast<size_t>(y) * width];
+				for (int x = columnRun.first; x < columnRun.end; ++x)
+				{
+					float& stored = target[m_cacheGrid.columns[x] - columnRun.tile * tileSize];
+					if (!std::isnan(values[x]) && std::isnan(stored))
+					{
+						stored = values[x] * valueScale;
+						changed = true;
+					}
 				}
 			}
 
-			if (iterations != 0 && iterations < maxIterations)
+			if (changed)
 			{
-				iterations += 1 - std::log(lastDotProduct) / logthreshold;
+				m_tileCache.Store(key, std::move(merged));
 			}
-			else
+		}
+	}
+}
+
+bool MandelbrotCPURender::UsePerturbation(const RenderConfig& refConfig) const
+{
+	return refConfig.m_cpuEngine == CPUEngine::PERTURBATION;
+}
+
+double MandelbrotCPURender::GetPeriodicityTolerance(const RenderConfig& refConfig)
+{
+	if (!refConfig.m_periodicityEnabled)
+		return 0.0;
+
+	// distance between pixel centers is 2 / (zoom * height)
+	const double pixelSize = 2.0 / (refConfig.m_zoom * GetEquivalentHeight(refConfig));
+	return pixelSize * s_periodicityPixelFraction;
+}
+
+double MandelbrotCPURender::GetEquivalentHeight(const RenderConfig& refConfig)
+{
+	if (!refConfig.m_exponentialMap)
+		return refConfig.m_windowSize.height;
+
+	// the inner row of an exponential map is at radius scale / 2: pi * scale / width apart along it
+	// and about ln(2) * scale / (2 * height) to the next row
+	const double alongRow = 2.0 * refConfig.m_windowSize.width / std::numbers::pi;
+	const double acrossRows = 4.0 * refConfig.m_windowSize.height / std::log(2.0);
+	return std::max(alongRow, acrossRows);
+}
+
+void MandelbrotCPURender::StopMainWorker()
+{
+	m_cancelRequested.store(true, std::memory_order_relaxed);
+}
+
+void MandelbrotCPURender::CleanupMainWorker()
+{
+	m_renderTasks->Wait();
+	m_cancelRequested.store(false, std::memory_order_relaxed);
+	m_reportPending = false;
+}
+
+void MandelbrotCPURender::WorkerDraw(const RenderConfig& refConfig, const int workerID, const int threadCount)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int width = m_currentResolution.width;
+	const int height = m_currentResolution.height;
+	const int tileSize = GetTileSize(refConfig);
+	const bool useTiles = tileSize > 0;
+
+	const DrawContext context = MakeDrawContext(refConfig);
+	if (Trace::IsRecording())
+	{
+		Trace::SetThreadName("CPU render worker");
+	}
+
+	// spans are tile rows and, for Mariani-Silver, tile columns; the supersampling pass takes the sub-samples of a pixel
+	WorkerScratch scratch;
+	const size_t spanWidth = static_cast<size_t>(std::max(useTiles ? std::min(tileSize, std::max(width, height)) : width, context.maxSubsamples));
+	scratch.x.resize(spanWidth);
+	scratch.y.resize(spanWidth);
+	scratch.values.resize(spanWidth);
+	if (context.doubleDouble)
+	{
+		scratch.wideX.resize(spanWidth);
+		scratch.wideY.resize(spanWidth);
+	}
+
+	bool canceled = false;
+
+	auto drawTile = [&](const RenderTile& tile)
+	{
+		const Clock::time_point tileStart = Clock::now();
+		if (m_supersamplePass)
+		{
+			SupersampleTile(context, tile, scratch);
+		}
+		else
+		{
+			switch (m_drawMode)
 			{
-				iterations = 0;
+			case DrawMode::PROGRESSIVE:
+				DrawProgressivePass(context, m_progressiveStep, tile, scratch);
+				break;
+			case DrawMode::MARIANI_SILVER:
+				DrawMarianiSilver(context, tile.x, tile.y, tile.width, tile.height, scratch);
+				break;
+			case DrawMode::MISSING_PIXELS:
+				DrawMissingPixels(context, tile, scratch);
+				break;
+			case DrawMode::RECOLOR:
+				ColorStoredPixels(context, tile);
+				DrawMissingPixels(context, tile, scratch);
+				break;
+			default:
+				DrawRows(context, tile.x, tile.y, tile.width, tile.height, scratch);
+				break;
 			}
+		}
+		const Clock::time_point tileEnd = Clock::now();
+		const double tileTime = std::chrono::duration<double, std::milli>(tileEnd - tileStart).count();
+		m_tileTimes[tile.index] += tileTime;
+		Trace::Complete("Tile", tileStart, tileEnd, "index", static_cast<int64_t>(tile.index));
 
-			iterations += OFFSET_COLOR;
-			double it = 0.0;
-			const double fraction = modf(iterations, &it);
+		// progressive passes run the workers once per pass, the counters add up
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		m_workerBusyTimes[workerID] += tileTime;
+		m_workerStats[workerID] += scratch.stats;
+		scratch.stats = kernels::EscapeStats();
+		m_refinedPixels += scratch.refinedPixels;
+		m_subsamples += scratch.subsamples;
+		scratch.refinedPixels = 0;
+		scratch.subsamples = 0;
+		if (m_firstPixelTime < 0.0)
+		{
+			m_firstPixelTime = std::chrono::duration<double, std::milli>(tileEnd - m_jobStart).count();
+		}
+	};
 
-			const int* color1 = PALETTE[static_cast<size_t>(it) % PALETTE_SIZE];
-			const int* color2 = PALETTE[static_cast<size_t>(it + 1) % PALETTE_SIZE];
-			
-			const double r = std::lerp(color1[0], color2[0], fraction);
-			const double g = std::lerp(color1[1], color2[1], fraction);
-			const double b = std::lerp(color1[2], color2[2], fraction);
+	if (useTiles)
+	{
+		RenderTile tile;
+		while (m_tileScheduler.Next(tile))
+		{
+			canceled = m_cancelRequested.load(std::memory_order_relaxed);
+			if (canceled)
+				break;
 
-			const size_t pos = (x + y * width) * s_sizeofRGB;
+			drawTile(tile);
+		}
+	}
+	else
+	{
+		for (int y = workerID; y < height; y += threadCount)
+		{
+			canceled = m_cancelRequested.load(std::memory_order_relaxed);
+			if (canceled)
+				break;
 
-			m_bufferData[pos + s_offesetR] = static_cast<unsigned char>(r);
-			m_bufferData[pos + s_offesetG] = static_cast<unsigned char>(g);
-			m_bufferData[pos + s_offesetB] = static_cast<unsigned char>(b);
+			drawTile(RenderTile{ static_cast<size_t>(y), 0, y, width, 1 });
 		}
 	}
 
+	{
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		m_workerFinishTimes[workerID] = std::chrono::duration<double, std::milli>(Clock::now() - m_jobStart).count();
+	}
 	if (canceled)
 	{
-		std::memset(m_bufferData.get(), 0, m_sizeData);
+		Trace::Instant("Worker canceled");
 	}
-}
 
-void MandelbrotCPURender::WorkerGrayDraw(const RenderConfig& refConfig, const int workerID, const int threadCount)
-{
-	const double scale = 1.0 / refConfig.m_zoom;
-	const size_t width = static_cast<unsigned long long>(refConfig.m_windowSize.width);
-	const size_t height = static_cast<unsigned long long>(refConfig.m_windowSize.height);
-	const math::vec2d resolution = math::toVec2d(refConfig.m_windowSize);
-	const math::vec2d position = refConfig.m_position;
-	const float threshold = refConfig.m_threshold;
-	const int maxIterations = refConfig.m_maxIterations;
+	// a canceled frame stays on screen, its computed pixels can still be reused by the next pan
+	if (m_passWorkersLeft.fetch_sub(1, std::memory_order_acq_rel) != 1 || m_cancelRequested.load(std::memory_order_relaxed))
+		return;
 
-	bool canceled = false;
+	// the last worker of a pass starts the next one, the group stays busy in between
+	if (m_drawMode == DrawMode::PROGRESSIVE && !m_supersamplePass)
+	{
+		m_passTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - m_jobStart).count());
+		Trace::Instant("Progressive pass done", "step", m_progressiveStep);
+		if (m_progressiveStep > 1)
+		{
+			m_progressiveStep /= 2;
+			m_tileScheduler.Reset(width, height, tileSize);
+			SubmitWorkers();
+			return;
+		}
+	}
 
-	for (size_t y = workerID; y < height; y += threadCount)
+	// the supersampling pass compares every pixel with its neighbours, so it waits for the whole frame
+	if (!m_supersamplePass && context.maxSubsamples > 0)
 	{
-		if (canceled = m_cancelRequested.load(std::memory_order_relaxed))
-			break;
+		m_supersamplePass = true;
+		m_supersampleStart = std::chrono::duration<double, std::milli>(Clock::now() - m_jobStart).count();
+		Trace::Instant("Supersampling pass");
+		m_tileScheduler.Reset(width, height, tileSize);
+		SubmitWorkers();
+	}
+}
 
-		for (size_t x = 0; x < width; ++x)
-		{
-			math::vec2d coord(static_cast<double>(x), static_cast<double>(y));
+int MandelbrotCPURender::GetTileSize(const RenderConfig& refConfig)
+{
+	// Mariani-Silver and progressive passes need rectangles, interleaved rows fall back to the default tiles
+	if ((refConfig.m_marianiSilverEnabled || refConfig.m_progressiveEnabled) && refConfig.m_tileSize <= 0)
+		return s_rectTileSize;
 
-			math::vec2d c = scale * (2. * coord - resolution) / resolution.y - position;
+	return refConfig.m_tileSize;
+}
 
-			double distance = 0.0f;
-			double c2 = math::dot(c, c);
-				// skip computation inside M1 - http://iquilezles.org/www/articles/mset_1bulb/mset1bulb.htm
-			if ((256.0 * c2 * c2 - 96.0 * c2 + 32.0 * c.x - 3.0 < 0.0)
-				// skip computation inside M2 - http://iquilezles.org/www/articles/mset_2bulb/mset2bulb.htm
-				|| (16.0 * (c2 + 2.0 * c.x + 1.0) - 1.0 < 0.0))
-			{
-				distance = 0.0f;
-			}
-			else
-			{
+MandelbrotCPURender::DrawContext MandelbrotCPURender::MakeDrawContext(const RenderConfig& refConfig) const
+{
+	DrawContext context;
+	context.scale = 1.0 / refConfig.m_zoom;
+	context.width = static_cast<size_t>(refConfig.m_windowSize.width);
+	context.resolution = math::toVec2d(refConfig.m_windowSize);
+	context.position = refConfig.m_position;
+	context.color = refConfig.m_colorEnabled;
+	context.paletteOffset = refConfig.m_paletteOffset;
+	context.pixelSize = 2.0 * context.scale / GetEquivalentHeight(refConfig);
+	context.grayScale = static_cast<float>(4.0 * context.pixelSize / context.scale);
 
-				// iterate
-				double di = 1.0;
-				math::vec2d z;
-				double m2 = 0.0;
-				math::vec2d dz;
-				for (int i = 0; i < maxIterations; i++)
-				{
-					if (m2 > threshold)
-					{ 
-						di = 0.0; 
-						break;
-					}
+	const float threshold = refConfig.m_threshold;
+	const float logthreshold = std::log(threshold);
+	context.params = { threshold, context.color ? logthreshold : 0.0, refConfig.m_maxIterations, GetPeriodicityTolerance(refConfig) };
 
-					// Z' -> 2ZZ' + 1
-					dz = 2.0 * math::vec2d(z.x * dz.x - z.y * dz.y, z.x * dz.y + z.y * dz.x) + math::vec2d(1.0, 0.0);
+	context.perturbation = UsePerturbation(refConfig);
+	context.blaTable = refConfig.m_blaEnabled ? &m_blaTable : nullptr;
 
-					// Z -> Z + c			
-					z = math::vec2d(z.x * z.x - z.y * z.y + c.x, 2 * z.x * z.y + c.y);
+	context.doubleDouble = refConfig.m_cpuEngine == CPUEngine::DOUBLE_DOUBLE;
+	context.exponentialMap = refConfig.m_exponentialMap;
+	context.maxSubsamples = std::clamp(refConfig.m_maxSubsamples, 0, s_maxSubsamples);
+	context.wideScale = context.doubleDouble ? math::doubledouble(1.0) / math::doubledouble(refConfig.m_zoom) : math::doubledouble(context.scale);
+	context.widePosition = context.doubleDouble ? ToDoubleDouble(refConfig.m_deepPosition) : math::vec2<math::doubledouble>();
+	context.cacheGrid = UseTileCache(refConfig) && !m_cacheGrid.columns.empty() ? &m_cacheGrid : nullptr;
+	return context;
+}
 
-					m2 = dot(z, z);
-				}
+void MandelbrotCPURender::DrawRows(const DrawContext& context, const int x, const int y, const int width, const int height, WorkerScratch& scratch)
+{
+	for (int row = y; row < y + height; ++row)
+	{
+		const PixelSpan span = { static_cast<size_t>(x), static_cast<size_t>(row), static_cast<size_t>(width), false };
+		ComputeSpan(context, span, scratch);
+		WriteSpan(context, span, scratch.values.data());
+	}
+}
 
-				if (di <= 0.5)
-				{
-					// distance	
-					// d(c) = |Z|log|Z|/|Z'|
-					distance = 0.5 * sqrt(dot(z, z) / dot(dz, dz)) * log(dot(z, z));
-				}
+void MandelbrotCPURender::DrawMissingPixels(const DrawContext& context, const RenderTile& tile, WorkerScratch& scratch)
+{
+	for (int y = tile.y; y < tile.y + tile.height; ++y)
+	{
+		const float* values = &m_pixelValues[static_cast<size_t>(y) * context.width];
+
+		// runs of pixels without a value, the ones exposed by the pan or left over by a canceled frame
+		const int end = tile.x + tile.width;
+		int x = tile.x;
+		while (x < end)
+		{
+			if (!std::isnan(values[x]))
+			{
+				++x;
+				continue;
 			}
 
-			double result = std::clamp(pow(4.0 * distance / scale, 0.2), 0.0, 1.0);
-			int byte = static_cast<unsigned char>(result * 255);
+			// every other pixel is missing between the ones kept by a 2x zoom step, still one span with a step of 2
+			const int runStart = x;
+			const int step = x + 2 < end && !std::isnan(values[x + 1]) && std::isnan(values[x + 2]) ? 2 : 1;
+			int count = 0;
+			do
+			{
+				++count;
+				x += step;
+			} while (x < end && std::isnan(values[x]) && (step == 1 || !std::isnan(values[x - 1])));
+			x = runStart + (count - 1) * step + 1;
 
-			const size_t pos = (x + y * width) * s_sizeofRGB;
+			const PixelSpan span = { static_cast<size_t>(runStart), static_cast<size_t>(y), static_cast<size_t>(count), false, static_cast<size_t>(step) };
+			ComputeSpan(context, span, scratch);
+			WriteSpan(context, span, scratch.values.data());
+		}
+	}
+}
 
-			m_bufferData[pos + s_offesetR] = static_cast<unsigned char>(byte);
-			m_bufferData[pos + s_offesetG] = static_cast<unsigned char>(byte);
-			m_bufferData[pos + s_offesetB] = static_cast<unsigned char>(byte);
+void MandelbrotCPURender::ColorStoredPixels(const DrawContext& context, const RenderTile& tile)
+{
+	for (int y = tile.y; y < tile.y + tile.height; ++y)
+	{
+		const size_t rowStart = static_cast<size_t>(y) * context.width;
+		for (int x = tile.x; x < tile.x + tile.width; ++x)
+		{
+			const float value = m_pixelValues[rowStart + x];
+			if (!std::isnan(value))
+			{
+				WriteColor(context, (rowStart + x) * s_sizeofRGB, value);
+			}
 		}
 	}
 }
 
-void MandelbrotCPURender::MakeBufferData(size_t size)
+void MandelbrotCPURender::DrawMarianiSilver(const DrawContext& context, const int x, const int y, const int width, const int height, WorkerScratch& scratch)
 {
-	m_maxSizeData = size;
-	m_bufferData.reset(new unsigned char[size]);
-	std::memset(m_bufferData.get(), 0, m_maxSizeData);
+	// small rectangles are cheaper to compute than to subdivide further
+	if (width <= s_marianiSilverMinSize || height <= s_marianiSilverMinSize)
+	{
+		DrawRows(context, x, y, width, height, scratch);
+		return;
+	}
+
+	// the border: top and bottom rows, then the columns between them
+	const PixelSpan border[] =
+	{
+		{ static_cast<size_t>(x), static_cast<size_t>(y), static_cast<size_t>(width), false },
+		{ static_cast<size_t>(x), static_cast<size_t>(y + height - 1), static_cast<size_t>(width), false },
+		{ static_cast<size_t>(x), static_cast<size_t>(y + 1), static_cast<size_t>(height - 2), true },
+		{ static_cast<size_t>(x + width - 1), static_cast<size_t>(y + 1), static_cast<size_t>(height - 2), true },
+	};
+
+	// a border point is bounded when the kernel stopped it in a bulb, on a cycle or at maxIterations
+	const auto boundedPoints = [](const kernels::EscapeStats& stats) { return stats.bulbPoints + stats.periodicPoints + stats.maxIterationPoints; };
+	const size_t boundedBefore = boundedPoints(scratch.stats);
+	size_t borderCount = 0;
+	for (const PixelSpan& span : border)
+	{
+		ComputeSpan(context, span, scratch);
+		WriteSpan(context, span, scratch.values.data());
+		borderCount += span.count;
+	}
+
+	const int innerX = x + 1;
+	const int innerY = y + 1;
+	const int innerWidth = width - 2;
+	const int innerHeight = height - 2;
+
+	// The set is full, so a border of bounded points encloses only bounded points. A value of 0 does not prove it:
+	// points escaping at the first step produce 0 as well, and equal exterior values say nothing about the inside.
+	if (boundedPoints(scratch.stats) - boundedBefore == borderCount)
+	{
+		FillRect(context, innerX, innerY, innerWidth, innerHeight, 0.0);
+		return;
+	}
+
+	// split the inside into quadrants, each traces its own border
+	const int leftWidth = innerWidth / 2;
+	const int topHeight = innerHeight / 2;
+	DrawMarianiSilver(context, innerX, innerY, leftWidth, topHeight, scratch);
+	DrawMarianiSilver(context, innerX + leftWidth, innerY, innerWidth - leftWidth, topHeight, scratch);
+	DrawMarianiSilver(context, innerX, innerY + topHeight, leftWidth, innerHeight - topHeight, scratch);
+	DrawMarianiSilver(context, innerX + leftWidth, innerY + topHeight, innerWidth - leftWidth, innerHeight - topHeight, scratch);
+}
+
+void MandelbrotCPURender::DrawProgressivePass(const DrawContext& context, const int step, const RenderTile& tile, WorkerScratch& scratch)
+{
+	const int width = m_currentResolution.width;
+	const int height = m_currentResolution.height;
+	const bool firstPass = step == s_progressiveFirstStep;
+
+	// computed points are shown as step x step blocks until the next pass refines them
+	auto store = [&](const int x, const int y, const float value)
+	{
+		m_pixelValues[static_cast<size_t>(x) + static_cast<size_t>(y) * width] = value;
+		FillColor(context, x, y, std::min(step, width - x), std::min(step, height - y), value);
+	};
+
+	const int firstY = (tile.y + step - 1) / step * step;
+	for (int y = firstY; y < tile.y + tile.height; y += step)
+	{
+		// points new in this pass: every step on rows skipped by the previous passes, odd multiples of step on the others
+		const bool newRow = firstPass || (y / step) % 2 == 1;
+		const int pointStep = newRow ? step : 2 * step;
+		int x = (tile.x + step - 1) / step * step;
+		if (!newRow && (x / step) % 2 == 0)
+		{
+			x += step;
+		}
+
+		// runs of points without an agreed value go to the kernels together
+		PixelSpan run = { 0, static_cast<size_t>(y), 0, false, static_cast<size_t>(pointStep) };
+		auto flush = [&]()
+		{
+			if (run.count == 0)
+				return;
+
+			ComputeSpan(context, run, scratch);
+			for (size_t i = 0; i < run.count; ++i)
+			{
+				store(static_cast<int>(run.x + i * run.step), y, ToStoredValue(context, scratch.values[i]));
+			}
+			run.count = 0;
+		};
+
+		for (; x < tile.x + tile.width; x += pointStep)
+		{
+			float agreed = 0.0f;
+			if (!firstPass && GetAgreedValue(x, y, step, agreed))
+			{
+				flush();
+				store(x, y, agreed);
+				continue;
+			}
+
+			if (run.count == 0)
+			{
+				run.x = static_cast<size_t>(x);
+			}
+			++run.count;
+		}
+		flush();
+	}
+}
+
+bool MandelbrotCPURender::GetAgreedValue(const int x, const int y, const int step, float& outValue) const
+{
+	// neighbours from the previous passes: the two on the same row or column, or the four corners of the cell
+	const bool oddX = (x / step) % 2 == 1;
+	const bool oddY = (y / step) % 2 == 1;
+	const int offsetX = oddX ? step : 0;
+	const int offsetY = oddY ? step : 0;
+
+	const math::vec2i neighbours[] =
+	{
+		math::vec2i(x - offsetX, y - offsetY),
+		math::vec2i(x + offsetX, y + offsetY),
+		math::vec2i(x - offsetX, y + offsetY),
+		math::vec2i(x + offsetX, y - offsetY),
+	};
+	const size_t neighbourCount = oddX && oddY ? 4 : 2;
+
+	for (size_t i = 0; i < neighbourCount; ++i)
+	{
+		const math::vec2i& n = neighbours[i];
+		if (n.x < 0 || n.y < 0 || n.x >= m_currentResolution.width || n.y >= m_currentResolution.height)
+			return false;
+
+		const float value = m_pixelValues[static_cast<size_t>(n.x) + static_cast<size_t>(n.y) * m_currentResolution.width];
+		if (i == 0)
+		{
+			outValue = value;
+		}
+		else if (value != outValue)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void MandelbrotCPURender::SupersampleTile(const DrawContext& context, const RenderTile& tile, WorkerScratch& scratch)
+{
+	const size_t maxSubsamples = static_cast<size_t>(context.maxSubsamples);
+	const size_t firstSubsamples = std::min(static_cast<size_t>(s_firstSubsamples), maxSubsamples);
+	const float contrast = context.color ? s_iterationContrast : s_grayContrast;
+	// sub-samples add to the iterations only, the other counters stay per pixel
+	kernels::EscapeStats subsampleStats;
+
+	for (int y = tile.y; y < tile.y + tile.height; ++y)
+	{
+		for (int x = tile.x; x < tile.x + tile.width; ++x)
+		{
+			const size_t index = static_cast<size_t>(x) + static_cast<size_t>(y) * context.width;
+			// a flat pixel costs this check once, pixels kept by a pan are not checked again
+			if (m_pixelSamples[index] != 0)
+				continue;
+
+			m_pixelSamples[index] = 1;
+			if (!IsHighContrast(context, x, y))
+				continue;
+
+			// the colors are averaged: the mean value of an edge would take a color of neither side
+			unsigned char rgb[s_sizeofRGB] = {};
+			ToColor(context, m_pixelValues[index], rgb);
+			uint32_t sum[3] = { rgb[0], rgb[1], rgb[2] };
+			// spread of the sub-samples alone: the pixel point is known to differ from a neighbour
+			float low = std::numeric_limits<float>::max();
+			float high = std::numeric_limits<float>::lowest();
+
+			size_t count = 0;
+			size_t batch = firstSubsamples;
+			while (batch > 0)
+			{
+				ComputeSubsamples(context, x, y, count, batch, scratch, subsampleStats);
+				for (size_t i = 0; i < batch; ++i)
+				{
+					const float value = ToStoredValue(context, scratch.values[i]);
+					ToColor(context, value, rgb);
+					sum[0] += rgb[0];
+					sum[1] += rgb[1];
+					sum[2] += rgb[2];
+
+					const float contrastValue = ToContrastValue(context, value);
+					low = std::min(low, contrastValue);
+					high = std::max(high, contrastValue);
+				}
+				count += batch;
+
+				// the rest only where the first sub-samples disagree among themselves as well
+				batch = high - low > contrast ? maxSubsamples - count : 0;
+			}
+
+			const uint32_t samples = static_cast<uint32_t>(count + 1);
+			unsigned char* pixel = &m_bufferData[index * s_sizeofRGB];
+			for (size_t channel = 0; channel < s_sizeofRGB; ++channel)
+			{
+				pixel[channel] = static_cast<unsigned char>((sum[channel] + samples / 2) / samples);
+			}
+			m_pixelSamples[index] = static_cast<unsigned char>(samples);
+			++scratch.refinedPixels;
+			scratch.subsamples += count;
+		}
+	}
+	scratch.stats.iterations += subsampleStats.iterations;
+}
+
+bool MandelbrotCPURender::IsHighContrast(const DrawContext& context, const int x, const int y) const
+{
+	const int width = m_currentResolution.width;
+	const int height = m_currentResolution.height;
+	const float contrast = context.color ? s_iterationContrast : s_grayContrast;
+	const float center = ToContrastValue(context, m_pixelValues[static_cast<size_t>(x) + static_cast<size_t>(y) * width]);
+
+	const math::vec2i neighbours[] =
+	{
+		math::vec2i(x - 1, y),
+		math::vec2i(x + 1, y),
+		math::vec2i(x, y - 1),
+		math::vec2i(x, y + 1),
+	};
+	for (const math::vec2i& n : neighbours)
+	{
+		if (n.x < 0 || n.y < 0 || n.x >= width || n.y >= height)
+			continue;
+
+		// a NaN left by a canceled job compares false
+		const float value = ToContrastValue(context, m_pixelValues[static_cast<size_t>(n.x) + static_cast<size_t>(n.y) * width]);
+		if (std::abs(value - center) > contrast)
+			return true;
+	}
+	return false;
+}
+
+void MandelbrotCPURender::ComputeSubsamples(const DrawContext& context, const int x, const int y, const size_t first, const size_t count, WorkerScratch& scratch, kernels::EscapeStats& stats)
+{
+	// R2 low-discrepancy sequence: every prefix covers the pixel evenly, so a pixel refined further keeps its
+	// first sub-samples. It is jittered by a hash of the pixel, the same frame gets the same sub-samples again.
+	const double r2X = 0.7548776662466927;
+	const double r2Y = 0.5698402909980532;
+	uint32_t hash = static_cast<uint32_t>(x) * 0x9E3779B1u ^ static_cast<uint32_t>(y) * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+	const double jitterX = (hash & 0xFFFF) / 65536.0;
+	const double jitterY = (hash >> 16) / 65536.0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double n = static_cast<double>(first + i + 1);
+		const double u = jitterX + n * r2X;
+		const double v = jitterY + n * r2Y;
+		// the pixel point is the middle of the pixel
+		const math::vec2d coord(x + (u - std::floor(u)) - 0.5, y + (v - std::floor(v)) - 0.5);
+		const math::vec2d offset = GetViewOffset(coord, context.resolution, context.exponentialMap);
+		if (context.doubleDouble)
+		{
+			scratch.wideX[i] = context.wideScale * math::doubledouble(offset.x) - context.widePosition.x;
+			scratch.wideY[i] = context.wideScale * math::doubledouble(offset.y) - context.widePosition.y;
+		}
+		else
+		{
+			// perturbation takes deltas from the reference point
+			const math::vec2d c = context.scale * offset - (context.perturbation ? m_referenceOffset : context.position);
+			scratch.x[i] = c.x;
+			scratch.y[i] = c.y;
+		}
+	}
+	ComputePoints(context, count, scratch, stats);
+}
+
+void MandelbrotCPURender::ComputeSpan(const DrawContext& context, const PixelSpan& span, WorkerScratch& scratch)
+{
+	if (context.perturbation)
+	{
+		// pixel deltas from the reference point
+		FillSpanCoordinates(context.scale, context.resolution, m_referenceOffset, span, context.exponentialMap, scratch.x.data(), scratch.y.data());
+	}
+	else if (context.doubleDouble)
+	{
+		FillSpanCoordinates(context.wideScale, context.resolution, context.widePosition, span, context.exponentialMap, scratch.wideX.data(), scratch.wideY.data());
+	}
+	else if (context.cacheGrid)
+	{
+		// the grid point of the pixel, so that its value can be cached for any frame on the same grid
+		const CacheGrid& grid = *context.cacheGrid;
+		const size_t stepX = span.vertical ? 0 : span.step;
+		const size_t stepY = span.vertical ? span.step : 0;
+		for (size_t i = 0; i < span.count; ++i)
+		{
+			scratch.x[i] = std::ldexp(static_cast<double>(grid.columns[span.x + i * stepX]), grid.level);
+			scratch.y[i] = std::ldexp(static_cast<double>(grid.rows[span.y + i * stepY]), grid.level);
+		}
+	}
+	else
+	{
+		FillSpanCoordinates(context.scale, context.resolution, context.position, span, context.exponentialMap, scratch.x.data(), scratch.y.data());
+	}
+	ComputePoints(context, span.count, scratch, scratch.stats);
+}
+
+void MandelbrotCPURender::ComputePoints(const DrawContext& context, const size_t count, WorkerScratch& scratch, kernels::EscapeStats& stats)
+{
+	const kernels::EscapeParams& params = context.params;
+	double* values = scratch.values.data();
+
+	if (context.perturbation)
+	{
+		if (context.color)
+		{
+			kernels::SmoothIterationsPerturbation(params, m_referenceOrbit, context.blaTable, scratch.x.data(), scratch.y.data(), count, values, stats);
+		}
+		else
+		{
+			kernels::DistancePerturbation(params, m_referenceOrbit, context.blaTable, scratch.x.data(), scratch.y.data(), count, values, stats);
+		}
+	}
+	else if (context.doubleDouble)
+	{
+		if (context.color)
+		{
+			m_kernels.smoothIterationsDoubleDouble(params, scratch.wideX.data(), scratch.wideY.data(), count, values, stats);
+		}
+		else
+		{
+			m_kernels.distanceDoubleDouble(params, scratch.wideX.data(), scratch.wideY.data(), count, values, stats);
+		}
+	}
+	else
+	{
+		if (context.color)
+		{
+			m_kernels.smoothIterations(params, scratch.x.data(), scratch.y.data(), count, values, stats);
+		}
+		else
+		{
+			m_kernels.distance(params, scratch.x.data(), scratch.y.data(), count, values, stats);
+		}
+	}
+}
+
+void MandelbrotCPURender::WriteSpan(const DrawContext& context, const PixelSpan& span, const double* values)
+{
+	const size_t stride = (span.vertical ? context.width : 1) * span.step;
+	size_t pos = (span.x + span.y * context.width) * s_sizeofRGB;
+
+	for (size_t i = 0; i < span.count; ++i, pos += stride * s_sizeofRGB)
+	{
+		WritePixel(context, pos, values[i]);
+	}
+}
+
+void MandelbrotCPURender::FillRect(const DrawContext& context, const int x, const int y, const int width, const int height, const double value)
+{
+	const float stored = ToStoredValue(context, value);
+	for (int row = y; row < y + height; ++row)
+	{
+		float* values = &m_pixelValues[static_cast<size_t>(x) + static_cast<size_t>(row) * context.width];
+		std::fill(values, values + width, stored);
+	}
+	FillColor(context, x, y, width, height, stored);
+}
+
+void MandelbrotCPURender::FillColor(const DrawContext& context, const int x, const int y, const int width, const int height, const float value)
+{
+	// one pixel through the palette, the rest are copies
+	const size_t first = (static_cast<size_t>(x) + static_cast<size_t>(y) * context.width) * s_sizeofRGB;
+	WriteColor(context, first, value);
+	const unsigned char* rgb = &m_bufferData[first];
+
+	for (int row = y; row < y + height; ++row)
+	{
+		unsigned char* dst = &m_bufferData[(static_cast<size_t>(x) + static_cast<size_t>(row) * context.width) * s_sizeofRGB];
+		for (int i = 0; i < width; ++i, dst += s_sizeofRGB)
+		{
+			dst[s_offesetR] = rgb[s_offesetR];
+			dst[s_offesetG] = rgb[s_offesetG];
+			dst[s_offesetB] = rgb[s_offesetB];
+		}
+	}
+}
+
+void MandelbrotCPURender::WritePixel(const DrawContext& context, const size_t pos, const double value)
+{
+	const float stored = ToStoredValue(context, value);
+	m_pixelValues[pos / s_sizeofRGB] = stored;
+	WriteColor(context, pos, stored);
+}
+
+float MandelbrotCPURender::ToStoredValue(const DrawContext& context, const double value)
+{
+	// distances scale with the view and would leave the float range at deep zooms
+	return static_cast<float>(context.color ? value : value / context.pixelSize);
+}
+
+void MandelbrotCPURender::WriteColor(const DrawContext& context, const size_t pos, const float value)
+{
+	ToColor(context, value, &m_bufferData[pos]);
+}
+
+void MandelbrotCPURender::ToColor(const DrawContext& context, const float value, unsigned char* outPixel)
+{
+	if (context.color)
+	{
+		// the mask wraps the gradient index around the palette, negative offsets included
+		const int64_t step = static_cast<int64_t>(std::floor((value + context.paletteOffset) * PALETTE_STEPS));
+		const uint32_t rgb = PALETTE_GRADIENT[step & PALETTE_GRADIENT_MASK];
+
+		outPixel[s_offesetR] = static_cast<unsigned char>(rgb);
+		outPixel[s_offesetG] = static_cast<unsigned char>(rgb >> 8);
+		outPixel[s_offesetB] = static_cast<unsigned char>(rgb >> 16);
+	}
+	else
+	{
+		int byte = static_cast<unsigned char>(ToGrayLevel(context, value) * 255);
+
+		outPixel[s_offesetR] = static_cast<unsigned char>(byte);
+		outPixel[s_offesetG] = static_cast<unsigned char>(byte);
+		outPixel[s_offesetB] = static_cast<unsigned char>(byte);
+	}
+}
+
+float MandelbrotCPURender::ToGrayLevel(const DrawContext& context, const float value)
+{
+	// pow(x, 0.2) as 2^(0.2 * log2(x)), the clamped ends never reach the log
+	const float distance = value * context.grayScale;
+	return distance <= 0.0f ? 0.0f
+		: distance >= 1.0f ? 1.0f
+		: std::min(math::fastExp2(0.2f * math::fastLog2(distance)), 1.0f);
+}
+
+float MandelbrotCPURender::ToContrastValue(const DrawContext& context, const float value)
+{
+	// distances span orders of magnitude, the gray level follows what is seen
+	return context.color ? value : ToGrayLevel(context, value);
+}
+
+bool MandelbrotCPURender::FindPanShift(const RenderConfig& jobConfig, math::vec2i& outShift) const
+{
+	// only the position may differ from the previous job
+	RenderConfig unmoved = jobConfig;
+	unmoved.m_position = m_jobConfig.m_position;
+	unmoved.m_deepPosition = m_jobConfig.m_deepPosition;
+	if (unmoved != m_jobConfig)
+		return false;
+
+	// a moved center is no translation of an exponential map, only the same view passes
+	if (jobConfig.m_exponentialMap)
+	{
+		outShift = math::vec2i(0, 0);
+		return jobConfig.m_position == m_jobConfig.m_position && jobConfig.m_deepPosition == m_jobConfig.m_deepPosition;
+	}
+
+	// deep engines take the pan from the exact position, the double one may have lost it
+	const bool deep = jobConfig.m_cpuEngine != CPUEngine::STANDARD;
+	const math::vec2d delta = deep
+		? math::vec2d((jobConfig.m_deepPosition.x - m_jobConfig.m_deepPosition.x).toDouble(), (jobConfig.m_deepPosition.y - m_jobConfig.m_deepPosition.y).toDouble())
+		: jobConfig.m_position - m_jobConfig.m_position;
+
+	// c = scale * (2 * pixel - resolution) / resolution.y - position, so a pan of one pixel moves position by 2 * scale / resolution.y
+	const double pixelsPerUnit = jobConfig.m_zoom * m_currentResolution.height / 2.0;
+	const double shiftX = std::round(delta.x * pixelsPerUnit);
+	const double shiftY = std::round(delta.y * pixelsPerUnit);
+	if (std::abs(shiftX) >= m_currentResolution.width || std::abs(shiftY) >= m_currentResolution.height)
+		return false;
+
+	outShift = math::vec2i(static_cast<int>(shiftX), static_cast<int>(shiftY));
+	return true;
+}
+
+bool MandelbrotCPURender::IsPresentationChange(const RenderConfig& jobConfig) const
+{
+	if (jobConfig.m_colorEnabled == m_jobConfig.m_colorEnabled && jobConfig.m_paletteOffset == m_jobConfig.m_paletteOffset
+		&& jobConfig.m_maxSubsamples == m_jobConfig.m_maxSubsamples)
+		return false;
+
+	// the position is compared as a pan: the previous job may have snapped it by a fraction of a pixel
+	RenderConfig view = jobConfig;
+	view.m_colorEnabled = m_jobConfig.m_colorEnabled;
+	view.m_paletteOffset = m_jobConfig.m_paletteOffset;
+	view.m_maxSubsamples = m_jobConfig.m_maxSubsamples;
+	math::vec2i shift;
+	return FindPanShift(view, shift) && shift == math::vec2i(0, 0);
+}
+
+bool MandelbrotCPURender::IsSameView(const RenderConfig& lhs, const RenderConfig& rhs)
+{
+	RenderConfig view = rhs;
+	view.m_colorEnabled = lhs.m_colorEnabled;
+	view.m_paletteOffset = lhs.m_paletteOffset;
+	view.m_maxSubsamples = lhs.m_maxSubsamples;
+	return view == lhs;
+}
+
+bool MandelbrotCPURender::IsZoomChange(const RenderConfig& jobConfig) const
+{
+	// zoom and position may differ from the previous job
+	RenderConfig unzoomed = jobConfig;
+	unzoomed.m_zoom = m_jobConfig.m_zoom;
+	unzoomed.m_position = m_jobConfig.m_position;
+	unzoomed.m_deepPosition = m_jobConfig.m_deepPosition;
+	// the octaves of an exponential map do not overlap, there is nothing to resample
+	return unzoomed == m_jobConfig && jobConfig.m_zoom != m_jobConfig.m_zoom && !jobConfig.m_exponentialMap;
+}
+
+size_t MandelbrotCPURender::ReprojectFrame(const RenderConfig& jobConfig, const CacheGrid& cacheGrid)
+{
+	const int width = m_currentResolution.width;
+	const int height = m_currentResolution.height;
+	const std::vector<unsigned char> previousRGB(m_bufferData.data(), m_bufferData.data() + m_sizeData);
+	const std::vector<float> previousValues(m_pixelValues.begin(), m_pixelValues.end());
+	m_pixelValues.assign(previousValues.size(), std::numeric_limits<float>::quiet_NaN());
+
+	const bool deep = jobConfig.m_cpuEngine != CPUEngine::STANDARD;
+	const math::vec2d delta = deep
+		? math::vec2d((jobConfig.m_deepPosition.x - m_jobConfig.m_deepPosition.x).toDouble(), (jobConfig.m_deepPosition.y - m_jobConfig.m_deepPosition.y).toDouble())
+		: jobConfig.m_position - m_jobConfig.m_position;
+
+	// solving scale * (2 * pixel - resolution) / resolution.y - position for the previous pixel of the same point:
+	// previous = (resolution + ratio * (2 * pixel - resolution) - resolution.y * zoom * delta) / 2, ratio = previous scale / new scale
+	const double ratio = m_jobConfig.m_zoom / jobConfig.m_zoom;
+	const double offsetX = height * m_jobConfig.m_zoom * delta.x;
+	const double offsetY = height * m_jobConfig.m_zoom * delta.y;
+
+	// with a power of two step around the same center the arithmetic is exact, points landing on a previous pixel keep its value
+	int exponent = 0;
+	const bool exactSteps = std::frexp(ratio, &exponent) == 0.5 && offsetX == 0.0 && offsetY == 0.0;
+	// pixels computed on a cache grid keep their value only when both frames took the same grid point
+	const bool previousGrid = !m_cacheGrid.columns.empty();
+	const bool newGrid = !cacheGrid.columns.empty();
+	const auto sameGridPoint = [&](const size_t x, const size_t y, const size_t previousX, const size_t previousY)
+	{
+		if (!newGrid)
+			return true;
+		return std::ldexp(static_cast<double>(cacheGrid.columns[x]), cacheGrid.level) == std::ldexp(static_cast<double>(m_cacheGrid.columns[previousX]), m_cacheGrid.level)
+			&& std::ldexp(static_cast<double>(cacheGrid.rows[y]), cacheGrid.level) == std::ldexp(static_cast<double>(m_cacheGrid.rows[previousY]), m_cacheGrid.level);
+	};
+
+	// stored distances are in pixels, which shrink by the ratio; exact for a power of two
+	const DrawContext context = MakeDrawContext(jobConfig);
+	const float valueScale = jobConfig.m_colorEnabled ? 1.0f : static_cast<float>(1.0 / ratio);
+	size_t kept = 0;
+	for (int y = 0; y < height; ++y)
+	{
+		const double previousY = (height + ratio * (2.0 * y - height) - offsetY) / 2.0;
+		const double nearestY = std::floor(previousY + 0.5);
+		for (int x = 0; x < width; ++x)
+		{
+			const double previousX = (width + ratio * (2.0 * x - width) - offsetX) / 2.0;
+			const double nearestX = std::floor(previousX + 0.5);
+			const size_t pos = (static_cast<size_t>(x) + static_cast<size_t>(y) * width) * s_sizeofRGB;
+
+			if (nearestX < 0.0 || nearestY < 0.0 || nearestX >= width || nearestY >= height)
+			{
+				std::memset(&m_bufferData[pos], 0, s_sizeofRGB);
+				continue;
+			}
+
+			const size_t previous = static_cast<size_t>(nearestX) + static_cast<size_t>(nearestY) * width;
+			if (exactSteps && previousGrid == newGrid && previousX == nearestX && previousY == nearestY && !std::isnan(previousValues[previous])
+				&& sameGridPoint(x, y, static_cast<size_t>(nearestX), static_cast<size_t>(nearestY)))
+			{
+				const float value = previousValues[previous] * valueScale;
+				m_pixelValues[pos / s_sizeofRGB] = value;
+				WriteColor(context, pos, value);
+				++kept;
+			}
+			else
+			{
+				std::memcpy(&m_bufferData[pos], &previousRGB[previous * s_sizeofRGB], s_sizeofRGB);
+			}
+		}
+	}
+	return kept;
+}
+
+void MandelbrotCPURender::ShiftPixels(unsigned char* data, const math::vec2i& size, const size_t pixelBytes, const math::vec2i& shift, const unsigned char fill)
+{
+	// pixel (x, y) takes the old pixel (x - shift.x, y - shift.y), rows are moved in an order that never overwrites a source
+	const size_t rowBytes = static_cast<size_t>(size.width) * pixelBytes;
+	const size_t keptBytes = static_cast<size_t>(size.width - std::abs(shift.x)) * pixelBytes;
+	const size_t dstOffset = static_cast<size_t>(std::max(shift.x, 0)) * pixelBytes;
+	const size_t srcOffset = static_cast<size_t>(std::max(-shift.x, 0)) * pixelBytes;
+	const size_t exposedOffset = shift.x > 0 ? 0 : keptBytes;
+	const size_t exposedBytes = rowBytes - keptBytes;
+
+	for (int i = 0; i < size.height; ++i)
+	{
+		const int y = shift.y > 0 ? size.height - 1 - i : i;
+		const int srcY = y - shift.y;
+		unsigned char* dst = data + static_cast<size_t>(y) * rowBytes;
+		if (srcY < 0 || srcY >= size.height)
+		{
+			std::memset(dst, fill, rowBytes);
+			continue;
+		}
+
+		std::memmove(dst + dstOffset, data + static_cast<size_t>(srcY) * rowBytes + srcOffset, keptBytes);
+		std::memset(dst + exposedOffset, fill, exposedBytes);
+	}
+}
+
+void MandelbrotCPURender::FillSpanCoordinates(const double scale, const math::vec2d& resolution, const math::vec2d& position, const PixelSpan& span, const bool exponentialMap, double* outX, double* outY)
+{
+	const size_t stepX = span.vertical ? 0 : span.step;
+	const size_t stepY = span.vertical ? span.step : 0;
+	for (size_t i = 0; i < span.count; ++i)
+	{
+		math::vec2d coord(static_cast<double>(span.x + i * stepX), static_cast<double>(span.y + i * stepY));
+
+		math::vec2d c = exponentialMap
+			? scale * GetExponentialMapOffset(coord, resolution) - position
+			: scale * (2. * coord - resolution) / resolution.y - position;
+		outX[i] = c.x;
+		outY[i] = c.y;
+	}
+}
+
+void MandelbrotCPURender::FillSpanCoordinates(const math::doubledouble& scale, const math::vec2d& resolution, const math::vec2<math::doubledouble>& position, const PixelSpan& span, const bool exponentialMap, math::doubledouble* outX, math::doubledouble* outY)
+{
+	// same mapping as the double version, the pixel terms are exact in double and only the products need the extra precision
+	const size_t stepX = span.vertical ? 0 : span.step;
+	const size_t stepY = span.vertical ? span.step : 0;
+	for (size_t i = 0; i < span.count; ++i)
+	{
+		const math::vec2d coord(static_cast<double>(span.x + i * stepX), static_cast<double>(span.y + i * stepY));
+		// the offset of an exponential map is rounded in double, far below the pixel size
+		const math::vec2d offset = GetViewOffset(coord, resolution, exponentialMap);
+		outX[i] = scale * math::doubledouble(offset.x) - position.x;
+		outY[i] = scale * math::doubledouble(offset.y) - position.y;
+	}
+}
+
+math::vec2d MandelbrotCPURender::GetViewOffset(const math::vec2d& coord, const math::vec2d& resolution, const bool exponentialMap)
+{
+	return exponentialMap ? GetExponentialMapOffset(coord, resolution) : (2. * coord - resolution) / resolution.y;
+}
+
+math::vec2d MandelbrotCPURender::GetExponentialMapOffset(const math::vec2d& coord, const math::vec2d& resolution)
+{
+	// row y is at radius 2^(y / height - 1), so the next octave starts where the row past the last one would be;
+	// column x is at angle 2 * pi * x / width
+	const double radius = std::exp2(coord.y / resolution.y - 1.0);
+	const double angle = 2.0 * std::numbers::pi * coord.x / resolution.x;
+	return math::vec2d(radius * std::cos(angle), radius * std::sin(angle));
+}
+
+math::vec2<math::doubledouble> MandelbrotCPURender::ToDoubleDouble(const math::vec2<math::deepfixed>& value)
+{
+	// the leading double and the rounding error left behind by it
+	auto convert = [](const math::deepfixed& fixed)
+	{
+		const double hi = fixed.toDouble();
+		const double lo = (fixed - math::deepfixed(hi)).toDouble();
+		return math::doubledouble::twoSum(hi, lo);
+	};
+	return math::vec2<math::doubledouble>(convert(value.x), convert(value.y));
+}
+
+void MandelbrotCPURender::ReportTimings() const
+{
+	if (m_tileTimes.empty() || m_workerBusyTimes.empty())
+		return;
+
+	const auto [tileMin, tileMax] = std::minmax_element(m_tileTimes.begin(), m_tileTimes.end());
+	const double tileAverage = std::accumulate(m_tileTimes.begin(), m_tileTimes.end(), 0.0) / m_tileTimes.size();
+
+	const auto [busyMin, busyMax] = std::minmax_element(m_workerBusyTimes.begin(), m_workerBusyTimes.end());
+	const double busyAverage = std::accumulate(m_workerBusyTimes.begin(), m_workerBusyTimes.end(), 0.0) / m_workerBusyTimes.size();
+	const double imbalance = busyAverage > 0.0 ? (*busyMax / busyAverage - 1.0) * 100.0 : 0.0;
+	const double totalTime = *std::max_element(m_workerFinishTimes.begin(), m_workerFinishTimes.end());
+
+	char text[256] = {};
+	std::snprintf(text, sizeof(text),
+		"CPU render %dx%d (%s): %.2f ms | %zu units, min/avg/max %.3f/%.3f/%.3f ms | worker busy min/avg/max %.2f/%.2f/%.2f ms, imbalance %.1f%%",
+		m_currentResolution.width, m_currentResolution.height,
+		GetTileSize(m_jobConfig) > 0 ? (std::to_string(GetTileSize(m_jobConfig)) + "px tiles" + (m_jobConfig.m_marianiSilverEnabled ? ", Mariani-Silver" : "")).c_str() : "interleaved rows",
+		totalTime, m_tileTimes.size(), *tileMin, tileAverage, *tileMax, *busyMin, busyAverage, *busyMax, imbalance);
+	Logger::Log(LogLevel::INFO, text);
+
+	const RenderStats renderStats = GetRenderStats();
+	std::snprintf(text, sizeof(text), "CPU kernels: %zu iterations, %zu bulb pixels, %zu pixels at max iterations | first tile %.2f ms, %.1f Mpix/s",
+		renderStats.m_iterations, renderStats.m_bulbPixels, renderStats.m_maxIterationPixels, renderStats.m_firstPixelTime, renderStats.GetMegapixelsPerSecond());
+	Logger::Log(LogLevel::INFO, text);
+
+	if (m_zoomRatio != 0.0)
+	{
+		std::snprintf(text, sizeof(text), "CPU zoom: previous frame reprojected for x%.3f, %zu pixels kept", m_zoomRatio, m_keptPixels);
+		Logger::Log(LogLevel::INFO, text);
+	}
+	else if (m_drawMode == DrawMode::MISSING_PIXELS)
+	{
+		const size_t keptPixels = static_cast<size_t>(m_currentResolution.width - std::abs(m_panShift.x)) * (m_currentResolution.height - std::abs(m_panShift.y));
+		std::snprintf(text, sizeof(text), "CPU pan: frame shifted by (%d, %d) px, %zu pixels exposed",
+			m_panShift.x, m_panShift.y, static_cast<size_t>(m_currentResolution.width) * m_currentResolution.height - keptPixels);
+		Logger::Log(LogLevel::INFO, text);
+	}
+
+	if (m_drawMode == DrawMode::RECOLOR)
+	{
+		std::snprintf(text, sizeof(text), "CPU recolor: %zu of %zu pixels colored from stored values",
+			m_recoloredPixels, static_cast<size_t>(m_currentResolution.width) * m_currentResolution.height);
+		Logger::Log(LogLevel::INFO, text);
+	}
+
+	if (!m_cacheGrid.columns.empty())
+	{
+		const TileCacheStats stats = m_tileCache.GetStats();
+		std::snprintf(text, sizeof(text), "CPU tile cache: level %d, %zu pixels from cache | %zu hits, %zu misses, %zu evictions in total | %zu tiles, %.1f of %zu MB",
+			m_cacheGrid.level, m_cachedPixels, stats.hits, stats.misses, stats.evictions, stats.tiles, stats.bytes / 1048576.0, m_tileCache.GetCapacity() >> 20);
+		Logger::Log(LogLevel::INFO, text);
+	}
+
+	if (m_drawMode == DrawMode::PROGRESSIVE && !m_passTimes.empty())
+	{
+		// pass end times since the job start, the first one is when a usable image is on screen
+		std::string passes;
+		int step = s_progressiveFirstStep;
+		for (double passTime : m_passTimes)
+		{
+			std::snprintf(text, sizeof(text), "%s%dpx %.2f ms", passes.empty() ? "" : ", ", step, passTime);
+			passes += text;
+			step /= 2;
+		}
+		Logger::Log(LogLevel::INFO, "CPU progressive passes: " + passes);
+	}
+
+	if (m_supersamplePass)
+	{
+		const size_t pixelCount = static_cast<size_t>(m_currentResolution.width) * m_currentResolution.height;
+		std::snprintf(text, sizeof(text), "CPU supersampling: %zu of %zu pixels refined (%.1f%%), %zu sub-samples, up to %d per pixel | %.2f ms",
+			renderStats.m_refinedPixels, pixelCount, pixelCount > 0 ? 100.0 * renderStats.m_refinedPixels / pixelCount : 0.0,
+			renderStats.m_subsamples, std::clamp(m_jobConfig.m_maxSubsamples, 0, s_maxSubsamples), totalTime - m_supersampleStart);
+		Logger::Log(LogLevel::INFO, text);
+	}
+
+	if (m_jobConfig.m_periodicityEnabled && !UsePerturbation(m_jobConfig))
+	{
+		const size_t periodicPoints = renderStats.m_periodicPixels;
+		const size_t pixelCount = static_cast<size_t>(m_currentResolution.width) * m_currentResolution.height;
+		std::snprintf(text, sizeof(text), "CPU periodicity: %zu of %zu pixels stopped early (%.1f%%)",
+			periodicPoints, pixelCount, pixelCount > 0 ? 100.0 * periodicPoints / pixelCount : 0.0);
+		Logger::Log(LogLevel::INFO, text);
+	}
+
+	if (UsePerturbation(m_jobConfig) && m_referenceOrbit.IsValid())
+	{
+		std::snprintf(text, sizeof(text), "CPU reference orbit: %zu iterations, %zu fraction bits, %.2f ms%s",
+			m_referenceOrbit.GetLength(), m_referenceOrbit.GetPrecisionBits(), m_referenceTime, m_referenceReused ? " (reused)" : "");
+		Logger::Log(LogLevel::INFO, text);
+
+		if (m_jobConfig.m_blaEnabled)
+		{
+			std::snprintf(text, sizeof(text), "CPU BLA table: %zu levels, %.2f ms%s", m_blaTable.GetLevelCount(), m_blaTime, m_blaReused ? " (reused)" : "");
+			Logger::Log(LogLevel::INFO, text);
+		}
+	}
+}
+
+void MandelbrotCPURender::MakeBufferData(size_t size)
+{
+	m_maxSizeData = size;
+	m_bufferData.assign(size, 0);
+}
+
+void MandelbrotCPURender::WriteMappedHeaders()
+{
+	const int width = m_currentResolution.width;
+	const int height = m_currentResolution.height;
+
+	const auto putLittleEndian = [](unsigned char* out, uint32_t value)
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			out[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+	};
+
+	if (unsigned char* header = m_bufferData.GetHeader())
+	{
+		// BITMAPFILEHEADER and BITMAPINFOHEADER, a positive height keeps the rows from the bottom one.
+		// The size fields are 32-bit, larger files leave them 0 as allowed for uncompressed bitmaps.
+		const uint64_t fileSize = s_bmpHeaderSize + m_sizeData;
+		const bool fits = fileSize <= std::numeric_limits<uint32_t>::max();
+		std::memset(header, 0, s_bmpHeaderSize);
+		header[0] = 'B';
+		header[1] = 'M';
+		putLittleEndian(header + 2, fits ? static_cast<uint32_t>(fileSize) : 0);
+		putLittleEndian(header + 10, static_cast<uint32_t>(s_bmpHeaderSize));
+		putLittleEndian(header + 14, 40);
+		putLittleEndian(header + 18, static_cast<uint32_t>(width));
+		putLittleEndian(header + 22, static_cast<uint32_t>(height));
+		header[26] = 1;
+		header[28] = 24;
+		putLittleEndian(header + 34, fits ? static_cast<uint32_t>(m_sizeData) : 0);
+	}
+	else if (!m_bufferData.GetMappedPath().empty())
+	{
+		Logger::Log(LogLevel::ERR, "CPU mapped storage: cannot map " + m_bufferData.GetMappedPath() + ", the frame is kept in memory");
+	}
+
+	if (unsigned char* header = m_pixelValues.GetHeader())
+	{
+		// grayscale PFM, the negative scale marks little-endian floats; padded with spaces to the fixed size
+		char text[s_pfmHeaderSize + 1];
+		std::snprintf(text, sizeof(text), "Pf\n%d %d%*s\n-1.0\n", width, height, static_cast<int>(s_pfmHeaderSize) - 9 - std::snprintf(nullptr, 0, "%d %d", width, height), "");
+		std::memcpy(header, text, s_pfmHeaderSize);
+	}
+	else if (!m_pixelValues.GetMappedPath().empty())
+	{
+		Logger::Log(LogLevel::ERR, "CPU mapped storage: cannot map " + m_pixelValues.GetMappedPath() + ", the values are kept in memory");
+	}
 }
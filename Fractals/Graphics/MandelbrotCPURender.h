@@ -1,52 +1,312 @@
 #pragma once
 
-#include <thread>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <mutex>
 
 #include "Data/RenderConfig.h"
+#include "Data/RenderStats.h"
 #include "Data/DataBinder.h"
 #include "Math/vec.h"
+#include "Math/doubledouble.h"
+#include "CPU/EscapeKernels.h"
+#include "CPU/TileScheduler.h"
+#include "CPU/ReferenceOrbit.h"
+#include "CPU/BLATable.h"
+#include "CPU/TileCache.h"
+#include "CPU/PixelStorage.h"
+#include "Threading/ThreadPool.h"
 
 struct RenderConfig;
 
 class MandelbrotCPURender : public DataBinder<RenderConfig>
 {
 public:
-	MandelbrotCPURender();
+	explicit MandelbrotCPURender(size_t threadCount = ThreadPool::GetDefaultThreadCount());
+	// Uses `kernels` for CPUEngine::STANDARD instead of the fastest set the CPU supports, e.g. to compare them
+	MandelbrotCPURender(size_t threadCount, const kernels::KernelSet& kernels);
 	~MandelbrotCPURender();
 
 	void OnUpdate();
-	void OnRender();
-	
+
 	bool IsBusy() const;
+	// Blocks until the current job is done and finishes it, without looking for config changes
+	void Wait();
+
+	// BGR rows of the last job from the bottom one, as glDrawPixels takes them with GL_BGR; null before the first job
+	const unsigned char* GetFrameData() const;
+	const math::vec2i& GetFrameSize() const;
+	// Kernel output of every pixel of the last job in the same row order: smooth iterations, or distances in pixels
+	// in the gray mode; NaN for pixels not computed yet. Null before the first job
+	const float* GetPixelValues() const;
+	// Kernel counters of the last job summed over the workers, only the pixels it computed
+	kernels::EscapeStats GetKernelStats() const;
+	// Counters and timings of the last job, updated after every tile so it can be polled while the job runs
+	RenderStats GetRenderStats() const;
+
+	// Keeps the frame and the value plane in memory-mapped files instead of the heap, empty paths go back to the heap.
+	// The frame file is a 24-bit BMP and the value file a grayscale PFM: both store rows from the bottom one like the
+	// buffers, so the workers write the files in place and an interrupted render leaves the rows finished so far.
+	// BMP rows are unpadded only for widths that are a multiple of 4: a job of another width drops the frame file with
+	// an error and keeps the frame in memory. Takes effect with the next job.
+	void SetMappedStorage(const std::string& framePath, const std::string& valuesPath);
+	// false when the frame is in memory, also after a failed mapping
+	bool IsFrameMapped() const;
+
+	// Deepest zoom the coming jobs reach around the current center, e.g. the end of an animation: the reference
+	// orbit is computed once with the precision for it and serves all of them. 0 - the zoom of every job.
+	void SetDeepestZoom(double zoom);
 
 private:
 	void StartMainWorker();
 	void StopMainWorker();
 	void CleanupMainWorker();
+	// Reports the timings and fills the tile cache once the workers of the job are done
+	void FinishJob();
+	void SubmitWorkers();
+	void PrepareReferenceOrbit();
+
+	struct WorkerScratch
+	{
+		std::vector<double> x;
+		std::vector<double> y;
+		std::vector<double> values;
+		// pixel coordinates of CPUEngine::DOUBLE_DOUBLE
+		std::vector<math::doubledouble> wideX;
+		std::vector<math::doubledouble> wideY;
+		kernels::EscapeStats stats;
+		// supersampling pass counters since the last tile
+		size_t refinedPixels = 0;
+		size_t subsamples = 0;
+	};
+
+	// Tile cache grid of a frame: pixel (x, y) is computed at c = 2^level * (columns[x], rows[y]), the grid point
+	// nearest to it at the level whose spacing is the largest power of two not above the pixel size
+	struct CacheGrid
+	{
+		int level;
+		std::vector<int64_t> columns;
+		std::vector<int64_t> rows;
+	};
+
+	// Frame columns or rows [first, end) whose grid points are on the same tile of the cache
+	struct CacheTileRun
+	{
+		int64_t tile;
+		int first;
+		int end;
+	};
+
+	// Per-render constants shared by every span a worker draws
+	struct DrawContext
+	{
+		kernels::EscapeParams params;
+		double scale;
+		size_t width;
+		math::vec2d resolution;
+		math::vec2d position;
+		bool color;
+		float paletteOffset;
+		// size of a pixel in the complex plane, the unit of stored distances
+		double pixelSize;
+		// stored distance to the gray mode input
+		float grayScale;
+		bool perturbation;
+		const BLATable* blaTable;
+		bool doubleDouble;
+		bool exponentialMap;
+		// 0 - no supersampling pass
+		int maxSubsamples;
+		math::doubledouble wideScale;
+		math::vec2<math::doubledouble> widePosition;
+		// points snapped to the tile cache grid, null when the job does not use the cache
+		const CacheGrid* cacheGrid;
+	};
+
+	// How the workers draw their tiles in the current job
+	enum class DrawMode
+	{
+		ROWS,
+		MARIANI_SILVER,
+		PROGRESSIVE,
+		// only pixels without a value, after a pan or zoom step kept part of the previous frame
+		MISSING_PIXELS,
+		// colors the stored values again after a presentation change, computes only pixels without a value
+		RECOLOR,
+	};
+
+	// A part of a pixel row, or of a column, evaluated by one kernel call
+	struct PixelSpan
+	{
+		size_t x;
+		size_t y;
+		size_t count;
+		bool vertical;
+		// pixels between consecutive points
+		size_t step = 1;
+	};
+
+	void WorkerDraw(const RenderConfig& refConfig, const int workerID, const int threadCount);
+	DrawContext MakeDrawContext(const RenderConfig& refConfig) const;
+	void DrawRows(const DrawContext& context, const int x, const int y, const int width, const int height, WorkerScratch& scratch);
+	void DrawMissingPixels(const DrawContext& context, const RenderTile& tile, WorkerScratch& scratch);
+	void ColorStoredPixels(const DrawContext& context, const RenderTile& tile);
+	// Computes only the border of the rectangle, fills it when the border agrees and subdivides otherwise
+	void DrawMarianiSilver(const DrawContext& context, const int x, const int y, const int width, const int height, WorkerScratch& scratch);
+	// Computes the points of the pass with spacing `step` inside the tile, coarser passes must be complete
+	void DrawProgressivePass(const DrawContext& context, const int step, const RenderTile& tile, WorkerScratch& scratch);
+	bool GetAgreedValue(const int x, const int y, const int step, float& outValue) const;
+	// Adds jittered sub-samples to the pixels of the tile that differ sharply from a neighbour, more where they disagree
+	void SupersampleTile(const DrawContext& context, const RenderTile& tile, WorkerScratch& scratch);
+	bool IsHighContrast(const DrawContext& context, const int x, const int y) const;
+	// Evaluates sub-samples first..first + count - 1 of pixel (x, y) into scratch.values
+	void ComputeSubsamples(const DrawContext& context, const int x, const int y, const size_t first, const size_t count, WorkerScratch& scratch, kernels::EscapeStats& stats);
+	void ComputeSpan(const DrawContext& context, const PixelSpan& span, WorkerScratch& scratch);
+	// Runs the kernels of the engine over the coordinates already in the scratch
+	void ComputePoints(const DrawContext& context, const size_t count, WorkerScratch& scratch, kernels::EscapeStats& stats);
+	void WriteSpan(const DrawContext& context, const PixelSpan& span, const double* values);
+	// Rect and Pixel store the kernel output as well, Color only writes the RGB buffer from a stored value
+	void FillRect(const DrawContext& context, const int x, const int y, const int width, const int height, const double value);
+	void FillColor(const DrawContext& context, const int x, const int y, const int width, const int height, const float value);
+	void WritePixel(const DrawContext& context, const size_t pos, const double value);
+	void WriteColor(const DrawContext& context, const size_t pos, const float value);
+	static void ToColor(const DrawContext& context, const float value, unsigned char* outPixel);
+	// Kernel output as kept in m_pixelValues: smooth iterations as they are, distances in pixels
+	static float ToStoredValue(const DrawContext& context, const double value);
+	// Shade of a stored distance in the gray mode, 0..1
+	static float ToGrayLevel(const DrawContext& context, const float value);
+	// Stored value on the scale the supersampling contrast is measured: iterations, or the gray level
+	static float ToContrastValue(const DrawContext& context, const float value);
 
-	void MainWorker(const RenderConfig copyConfig);
-	void WorkerColorDraw(const RenderConfig& refConfig, const int workerID, const int threadCount);
-	void WorkerGrayDraw(const RenderConfig& refConfig, const int workerID, const int threadCount);
+	// Whole pixel translation from the previous job to `jobConfig`, false when more than the position changed
+	bool FindPanShift(const RenderConfig& jobConfig, math::vec2i& outShift) const;
+	// True when only presentation settings (color mode, palette offset) changed from the previous job
+	bool IsPresentationChange(const RenderConfig& jobConfig) const;
+	static bool IsSameView(const RenderConfig& lhs, const RenderConfig& rhs);
+	// True when only the zoom and the position changed from the previous job
+	bool IsZoomChange(const RenderConfig& jobConfig) const;
+	// Writes the previous frame resampled to `jobConfig` as a preview,
+	// returns the number of pixels whose previous value is exact for the new view and was kept
+	size_t ReprojectFrame(const RenderConfig& jobConfig, const CacheGrid& cacheGrid);
+	static void ShiftPixels(unsigned char* data, const math::vec2i& size, const size_t pixelBytes, const math::vec2i& shift, const unsigned char fill);
+
+	// The tile cache: pixels are computed on its grid, frames are filled from it before the workers start
+	// and their values are stored back once the job finished or was canceled
+	bool UseTileCache(const RenderConfig& refConfig) const;
+	static void MakeCacheGrid(const RenderConfig& refConfig, const math::vec2i& resolution, CacheGrid& outGrid);
+	static std::vector<CacheTileRun> GetCacheTileRuns(const std::vector<int64_t>& indices);
+	CachedTileKey MakeCacheKey(const int64_t tileX, const int64_t tileY) const;
+	// Stored value times the factor is the cached value: distances are kept in units of the grid spacing
+	float GetCacheValueScale() const;
+	void FillFromTileCache();
+	void StoreToTileCache();
+
+	bool UsePerturbation(const RenderConfig& refConfig) const;
+	static double GetPeriodicityTolerance(const RenderConfig& refConfig);
+	static int GetTileSize(const RenderConfig& refConfig);
+	// Height of a plain view whose pixels are as close as the closest ones of `refConfig`
+	static double GetEquivalentHeight(const RenderConfig& refConfig);
+
+	static void FillSpanCoordinates(const double scale, const math::vec2d& resolution, const math::vec2d& position, const PixelSpan& span, const bool exponentialMap, double* outX, double* outY);
+	static void FillSpanCoordinates(const math::doubledouble& scale, const math::vec2d& resolution, const math::vec2<math::doubledouble>& position, const PixelSpan& span, const bool exponentialMap, math::doubledouble* outX, math::doubledouble* outY);
+	// Offset of a point of the frame from the view center in units of the scale, fractional pixel coordinates included
+	static math::vec2d GetViewOffset(const math::vec2d& coord, const math::vec2d& resolution, const bool exponentialMap);
+	// Offset of the pixel from the center of an exponential map, in units of the scale
+	static math::vec2d GetExponentialMapOffset(const math::vec2d& coord, const math::vec2d& resolution);
+	static math::vec2<math::doubledouble> ToDoubleDouble(const math::vec2<math::deepfixed>& value);
+
+	void ReportTimings() const;
 
 	void MakeBufferData(size_t size);
+	void WriteMappedHeaders();
 
-	std::thread m_mainThread;
+	std::unique_ptr<ThreadPool> m_threadPool;
+	std::unique_ptr<TaskGroup> m_renderTasks;
 
 	std::atomic<bool> m_cancelRequested;
-	std::atomic<bool> m_isBusy;
+	bool m_reportPending;
 
 	RenderConfig m_prevConfig;
+	RenderConfig m_jobConfig;
 
 	math::vec2i m_currentResolution;
 
+	TileScheduler m_tileScheduler;
+	std::vector<double> m_tileTimes;
+	// the worker counters below are added to after every tile and read by GetRenderStats under m_statsMutex
+	mutable std::mutex m_statsMutex;
+	std::vector<double> m_workerBusyTimes;
+	std::vector<double> m_workerFinishTimes;
+	std::vector<kernels::EscapeStats> m_workerStats;
+	double m_firstPixelTime;
+	std::chrono::steady_clock::time_point m_jobStart;
+
+	DrawMode m_drawMode;
+	math::vec2i m_panShift;
+	// new zoom / previous zoom of a reprojected job, 0 otherwise
+	double m_zoomRatio;
+	size_t m_keptPixels;
+
+	// progressive passes: current point spacing, workers still running the pass, pass end times
+	int m_progressiveStep;
+	std::atomic<int> m_passWorkersLeft;
+	std::vector<double> m_passTimes;
+	// kernel output of every pixel in the frame, NaN until computed; shifted on pans, compared by progressive passes
+	PixelStorage<float> m_pixelValues;
+	// the plane of the other color mode, valid while the view of m_otherValuesConfig is on screen
+	PixelStorage<float> m_otherValues;
+	RenderConfig m_otherValuesConfig;
+	size_t m_recoloredPixels;
+
+	// supersampling pass: running after the frame is complete, its start since the job start;
+	// samples behind the color of every pixel, 0 until the pass checked it and 1 for the pixel point only
+	bool m_supersamplePass;
+	double m_supersampleStart;
+	std::vector<unsigned char> m_pixelSamples;
+	// summed over the workers under m_statsMutex
+	size_t m_refinedPixels;
+	size_t m_subsamples;
+
+	TileCache m_tileCache;
+	// grid of the current job, empty when it does not use the cache
+	CacheGrid m_cacheGrid;
+	// lookups of the current job and the pixels they filled
+	size_t m_cacheHits;
+	size_t m_cacheMisses;
+	size_t m_cachedPixels;
+	bool m_cacheStorePending;
+
+	ReferenceOrbit m_referenceOrbit;
+	BLATable m_blaTable;
+	// reference point minus view center, subtracted from pixel deltas the same way as m_position
+	math::vec2d m_referenceOffset;
+	double m_referenceTime;
+	double m_blaTime;
+	bool m_referenceReused;
+	bool m_blaReused;
+	double m_deepestZoom;
+
 	size_t m_sizeData;
 	size_t m_maxSizeData;
-	std::unique_ptr<unsigned char[]> m_bufferData;
+	PixelStorage<unsigned char> m_bufferData;
+
+	const kernels::KernelSet& m_kernels;
 
 	static const size_t s_sizeofRGB;
 	static const size_t s_offesetR;
 	static const size_t s_offesetG;
 	static const size_t s_offesetB;
+	static const size_t s_bmpHeaderSize;
+	static const size_t s_pfmHeaderSize;
+	static const double s_periodicityPixelFraction;
+	static const int s_rectTileSize;
+	static const int s_progressiveFirstStep;
+	static const int s_marianiSilverMinSize;
+	static const int s_maxSubsamples;
+	static const int s_firstSubsamples;
+	static const float s_iterationContrast;
+	static const float s_grayContrast;
 };
\ No newline at end of file
@@ -61,11 +61,12 @@ void MandelbrotGPURender::OnUpdate()
 		if (std::shared_ptr<RenderConfig> config = DataBinder<RenderConfig>::GetData())
 		{
 			(*m_fractalsShader)["iResolution"] = config->m_windowSize;
-			(*m_fractalsShader)["iScale"] = 1.0f / config->m_zoom;
+			(*m_fractalsShader)["iScale"] = static_cast<float>(1.0 / config->m_zoom);
 			(*m_fractalsShader)["iPosition"] = math::toVec2f(config->m_position + config->m_offset);
 			(*m_fractalsShader)["iThreshold"] = config->m_threshold;
 			(*m_fractalsShader)["iMaxIter"] = config->m_maxIterations;
 			(*m_fractalsShader)["iColor"] = config->m_colorEnabled;
+			(*m_fractalsShader)["iPaletteOffset"] = config->m_paletteOffset;
 		}
 	}
 }
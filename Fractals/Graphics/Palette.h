@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 const int OFFSET_COLOR = 84;
 const int PALETTE_SIZE = 256;
 const int PALETTE[PALETTE_SIZE][3] = {
@@ -67,4 +70,36 @@ const int PALETTE[PALETTE_SIZE][3] = {
 	{0x70, 0x64, 0x54}, {0x76, 0x69, 0x57}, {0x7C, 0x6E, 0x5A}, {0x82, 0x73, 0x5D},
 	{0x88, 0x78, 0x60}, {0x8D, 0x7C, 0x62}, {0x92, 0x80, 0x64}, {0x97, 0x84, 0x66},
 	{0x9C, 0x88, 0x68}, {0xA2, 0x8D, 0x6A}, {0xA8, 0x92, 0x6C}, {0xAE, 0x97, 0x6E}
-};
\ No newline at end of file
+};
+
+// PALETTE with PALETTE_STEPS interpolated colors between consecutive entries, packed as 0x00BBGGRR.
+// The color of smooth iteration count i is PALETTE_GRADIENT[floor(i * PALETTE_STEPS) & PALETTE_GRADIENT_MASK],
+// the same lerp and truncation as interpolating PALETTE directly, with the fraction rounded down to 1 / PALETTE_STEPS.
+const int PALETTE_STEPS = 64;
+const int PALETTE_GRADIENT_SIZE = PALETTE_SIZE * PALETTE_STEPS;
+const int PALETTE_GRADIENT_MASK = PALETTE_GRADIENT_SIZE - 1;
+static_assert((PALETTE_GRADIENT_SIZE & PALETTE_GRADIENT_MASK) == 0, "the gradient is indexed with a mask");
+
+constexpr std::array<uint32_t, PALETTE_GRADIENT_SIZE> MakePaletteGradient()
+{
+	std::array<uint32_t, PALETTE_GRADIENT_SIZE> gradient = {};
+	for (int i = 0; i < PALETTE_SIZE; ++i)
+	{
+		const int* color1 = PALETTE[i];
+		const int* color2 = PALETTE[(i + 1) % PALETTE_SIZE];
+		for (int step = 0; step < PALETTE_STEPS; ++step)
+		{
+			const double fraction = static_cast<double>(step) / PALETTE_STEPS;
+			uint32_t packed = 0;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				const double value = color1[channel] + fraction * (color2[channel] - color1[channel]);
+				packed |= static_cast<uint32_t>(value) << (8 * channel);
+			}
+			gradient[i * PALETTE_STEPS + step] = packed;
+		}
+	}
+	return gradient;
+}
+
+inline constexpr std::array<uint32_t, PALETTE_GRADIENT_SIZE> PALETTE_GRADIENT = MakePaletteGradient();
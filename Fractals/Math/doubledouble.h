@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cmath>
+
+namespace math
+{
+	// Unevaluated sum of two doubles hi + lo with |lo| <= ulp(hi) / 2, about 32 significant digits.
+	// Built on error-free transformations without FMA (Dekker, Knuth), so it needs strict IEEE evaluation:
+	// sources using it in hot loops are compiled with floating-point contraction disabled.
+	// Trivially copyable and implicitly constructible from double, so it can be used in vec2<T> and dot.
+	struct doubledouble
+	{
+		double hi;
+		double lo;
+
+		doubledouble() = default;
+
+		doubledouble(double value) : hi(value), lo(0.0) {}
+
+		doubledouble(double hi, double lo) : hi(hi), lo(lo) {}
+
+		double toDouble() const
+		{
+			return hi + lo;
+		}
+
+		// s + e = a + b exactly
+		static doubledouble twoSum(double a, double b)
+		{
+			const double s = a + b;
+			const double bb = s - a;
+			const double e = (a - (s - bb)) + (b - bb);
+			return doubledouble(s, e);
+		}
+
+		// s + e = a + b exactly, requires |a| >= |b|
+		static doubledouble quickTwoSum(double a, double b)
+		{
+			const double s = a + b;
+			return doubledouble(s, b - (s - a));
+		}
+
+		// p + e = a * b exactly (Dekker's product with Veltkamp splitting)
+		static doubledouble twoProd(double a, double b)
+		{
+			const double p = a * b;
+			double aHi, aLo, bHi, bLo;
+			split(a, aHi, aLo);
+			split(b, bHi, bLo);
+			const double e = ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+			return doubledouble(p, e);
+		}
+
+		doubledouble operator-() const
+		{
+			return doubledouble(-hi, -lo);
+		}
+
+		friend doubledouble operator+(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			const doubledouble s = twoSum(lhs.hi, rhs.hi);
+			const doubledouble t = twoSum(lhs.lo, rhs.lo);
+			doubledouble result = quickTwoSum(s.hi, s.lo + t.hi);
+			return quickTwoSum(result.hi, result.lo + t.lo);
+		}
+
+		friend doubledouble operator-(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return lhs + (-rhs);
+		}
+
+		friend doubledouble operator*(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			const doubledouble p = twoProd(lhs.hi, rhs.hi);
+			return quickTwoSum(p.hi, p.lo + (lhs.hi * rhs.lo + lhs.lo * rhs.hi));
+		}
+
+		friend doubledouble operator/(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			// long division: one double quotient digit per step
+			const double q1 = lhs.hi / rhs.hi;
+			const doubledouble r = lhs - rhs * doubledouble(q1);
+			const double q2 = r.hi / rhs.hi;
+			return quickTwoSum(q1, q2);
+		}
+
+		doubledouble& operator+=(const doubledouble& rhs)
+		{
+			return *this = *this + rhs;
+		}
+
+		doubledouble& operator-=(const doubledouble& rhs)
+		{
+			return *this = *this - rhs;
+		}
+
+		doubledouble& operator*=(const doubledouble& rhs)
+		{
+			return *this = *this * rhs;
+		}
+
+		friend bool operator==(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return lhs.hi == rhs.hi && lhs.lo == rhs.lo;
+		}
+
+		friend bool operator!=(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+		friend bool operator<(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return lhs.hi < rhs.hi || (lhs.hi == rhs.hi && lhs.lo < rhs.lo);
+		}
+
+		friend bool operator>(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return rhs < lhs;
+		}
+
+		friend bool operator<=(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return !(rhs < lhs);
+		}
+
+		friend bool operator>=(const doubledouble& lhs, const doubledouble& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+	private:
+		// a = hi + lo with both halves holding at most 26 significant bits
+		static void split(double a, double& outHi, double& outLo)
+		{
+			const double t = 134217729.0 * a; // 2^27 + 1
+			outHi = t - (t - a);
+			outLo = a - outHi;
+		}
+	};
+
+	inline doubledouble sqrt(const doubledouble& value)
+	{
+		// one Newton step from the double root
+		if (value.hi <= 0.0)
+			return doubledouble(0.0);
+
+		const double root = std::sqrt(value.hi);
+		const doubledouble square = doubledouble::twoProd(root, root);
+		return doubledouble::quickTwoSum(root, (value - square).hi * (0.5 / root));
+	}
+
+	inline double log(const doubledouble& value)
+	{
+		return std::log(value.hi) + value.lo / value.hi;
+	}
+
+	inline double toDouble(const doubledouble& value)
+	{
+		return value.toDouble();
+	}
+}
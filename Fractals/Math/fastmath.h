@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace math
+{
+	// Polynomial approximations for coloring, where a few ulps do not matter.
+	// Both split the argument into its binary exponent and a fraction in [0, 1) and fit the fraction
+	// with a degree 4 Chebyshev interpolant, so each is a handful of integer and float operations.
+
+	// log2(x) for normal x > 0, absolute error below 6e-5
+	inline float fastLog2(float x)
+	{
+		uint32_t bits = 0;
+		std::memcpy(&bits, &x, sizeof(bits));
+		const float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+
+		// mantissa in [1, 2): log2(1 + t) = t * q(t)
+		bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+		float mantissa = 0.0f;
+		std::memcpy(&mantissa, &bits, sizeof(mantissa));
+		const float t = mantissa - 1.0f;
+		const float q = 1.4426039f + t * (-0.71671468f + t * (0.44059902f + t * (-0.22510302f + t * 0.058664940f)));
+		return exponent + t * q;
+	}
+
+	inline float fastLog(float x)
+	{
+		return fastLog2(x) * 0.69314718f;
+	}
+
+	// 2^y, relative error below 4e-6; underflows to 0 below -126
+	inline float fastExp2(float y)
+	{
+		if (y < -126.0f)
+			return 0.0f;
+
+		const float whole = std::floor(y);
+		const float t = y - whole;
+		const float fraction = 1.0000035f + t * (0.69297290f + t * (0.24160436f + t * (0.051744998f + t * 0.013670309f)));
+
+		// the whole part goes straight into the exponent bits
+		uint32_t bits = 0;
+		std::memcpy(&bits, &fraction, sizeof(bits));
+		bits += static_cast<uint32_t>(static_cast<int>(whole)) << 23;
+		float result = 0.0f;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+}
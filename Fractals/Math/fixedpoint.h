@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cctype>
+#include <string>
+
+namespace math
+{
+	// Signed two's complement fixed-point number: a 32-bit integer part and FractionLimbs 32-bit fraction limbs.
+	// Trivially copyable, so it can be stored in vec2<T> and RenderConfig.
+	template<size_t FractionLimbs>
+	struct fixedpoint
+	{
+		static constexpr size_t fractionLimbs = FractionLimbs;
+		static constexpr size_t limbCount = FractionLimbs + 1;
+		static constexpr size_t fractionBits = FractionLimbs * 32;
+
+		// little-endian, limbs[FractionLimbs] holds the integer part
+		uint32_t limbs[limbCount];
+
+		fixedpoint() = default;
+
+		fixedpoint(double value)
+		{
+			const bool negative = value < 0.0;
+			double magnitude = std::fabs(value);
+			const double integer = std::floor(magnitude);
+
+			limbs[FractionLimbs] = static_cast<uint32_t>(static_cast<int64_t>(integer));
+			double fraction = magnitude - integer;
+			for (size_t i = FractionLimbs; i-- > 0;)
+			{
+				fraction *= 4294967296.0;
+				const double digit = std::floor(fraction);
+				limbs[i] = static_cast<uint32_t>(digit);
+				fraction -= digit;
+			}
+
+			if (negative)
+			{
+				negate();
+			}
+		}
+
+		// Converts between precisions, truncating or zero-extending the fraction
+		template<size_t OtherLimbs>
+		explicit fixedpoint(const fixedpoint<OtherLimbs>& other)
+		{
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				const ptrdiff_t source = static_cast<ptrdiff_t>(i) + static_cast<ptrdiff_t>(OtherLimbs) - static_cast<ptrdiff_t>(FractionLimbs);
+				limbs[i] = source >= 0 ? other.limbs[source] : 0u;
+			}
+		}
+
+		bool isNegative() const
+		{
+			return (limbs[FractionLimbs] & 0x80000000u) != 0;
+		}
+
+		bool isZero() const
+		{
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				if (limbs[i] != 0)
+					return false;
+			}
+			return true;
+		}
+
+		void negate()
+		{
+			uint64_t carry = 1;
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				const uint64_t sum = static_cast<uint64_t>(~limbs[i]) + carry;
+				limbs[i] = static_cast<uint32_t>(sum);
+				carry = sum >> 32;
+			}
+		}
+
+		fixedpoint abs() const
+		{
+			fixedpoint result = *this;
+			if (result.isNegative())
+			{
+				result.negate();
+			}
+			return result;
+		}
+
+		double toDouble() const
+		{
+			const fixedpoint magnitude = abs();
+			double result = 0.0;
+			for (size_t i = 0; i < FractionLimbs; ++i)
+			{
+				result = (result + magnitude.limbs[i]) * (1.0 / 4294967296.0);
+			}
+			result += magnitude.limbs[FractionLimbs];
+			return isNegative() ? -result : result;
+		}
+
+		fixedpoint operator-() const
+		{
+			fixedpoint result = *this;
+			result.negate();
+			return result;
+		}
+
+		fixedpoint operator+(const fixedpoint& rhs) const
+		{
+			fixedpoint result;
+			uint64_t carry = 0;
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				const uint64_t sum = static_cast<uint64_t>(limbs[i]) + rhs.limbs[i] + carry;
+				result.limbs[i] = static_cast<uint32_t>(sum);
+				carry = sum >> 32;
+			}
+			return result;
+		}
+
+		fixedpoint operator-(const fixedpoint& rhs) const
+		{
+			fixedpoint result;
+			int64_t borrow = 0;
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				const int64_t diff = static_cast<int64_t>(limbs[i]) - rhs.limbs[i] - borrow;
+				result.limbs[i] = static_cast<uint32_t>(diff);
+				borrow = diff < 0 ? 1 : 0;
+			}
+			return result;
+		}
+
+		// Truncated product: partial products that only affect bits below the last fraction limb are skipped
+		fixedpoint operator*(const fixedpoint& rhs) const
+		{
+			const fixedpoint a = abs();
+			const fixedpoint b = rhs.abs();
+
+			uint32_t product[limbCount * 2] = {};
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				uint64_t carry = 0;
+				const size_t firstJ = (i + 1 < FractionLimbs) ? FractionLimbs - 1 - i : 0;
+				for (size_t j = firstJ; j < limbCount; ++j)
+				{
+					const uint64_t t = static_cast<uint64_t>(a.limbs[i]) * b.limbs[j] + product[i + j] + carry;
+					product[i + j] = static_cast<uint32_t>(t);
+					carry = t >> 32;
+				}
+				product[i + limbCount] = static_cast<uint32_t>(carry);
+			}
+
+			fixedpoint result;
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				result.limbs[i] = product[i + FractionLimbs];
+			}
+
+			if (isNegative() != rhs.isNegative())
+			{
+				result.negate();
+			}
+			return result;
+		}
+
+		fixedpoint& operator+=(const fixedpoint& rhs)
+		{
+			return *this = *this + rhs;
+		}
+
+		fixedpoint& operator-=(const fixedpoint& rhs)
+		{
+			return *this = *this - rhs;
+		}
+
+		bool operator==(const fixedpoint& rhs) const
+		{
+			for (size_t i = 0; i < limbCount; ++i)
+			{
+				if (limbs[i] != rhs.limbs[i])
+					return false;
+			}
+			return true;
+		}
+
+		bool operator!=(const fixedpoint& rhs) const
+		{
+			return !(*this == rhs);
+		}
+
+		// Decimal representation with `digits` fraction digits (truncated)
+		std::string toString(int digits) const
+		{
+			fixedpoint magnitude = abs();
+			std::string result = isNegative() ? "-" : "";
+			result += std::to_string(magnitude.limbs[FractionLimbs]);
+			result += '.';
+
+			magnitude.limbs[FractionLimbs] = 0;
+			for (int d = 0; d < digits; ++d)
+			{
+				uint64_t carry = 0;
+				for (size_t i = 0; i < limbCount; ++i)
+				{
+					const uint64_t t = static_cast<uint64_t>(magnitude.limbs[i]) * 10 + carry;
+					magnitude.limbs[i] = static_cast<uint32_t>(t);
+					carry = t >> 32;
+				}
+				result += static_cast<char>('0' + magnitude.limbs[FractionLimbs]);
+				magnitude.limbs[FractionLimbs] = 0;
+			}
+			return result;
+		}
+
+		// Parses "[-]int[.fraction]", returns false on malformed input or integer part overflow
+		static bool fromString(const std::string& text, fixedpoint& outValue)
+		{
+			size_t pos = 0;
+			while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+				++pos;
+
+			bool negative = false;
+			if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+			{
+				negative = text[pos] == '-';
+				++pos;
+			}
+
+			uint64_t integer = 0;
+			size_t integerDigits = 0;
+			while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])))
+			{
+				integer = integer * 10 + (text[pos] - '0');
+				if (integer > 0x7FFFFFFFu)
+					return false;
+				++pos;
+				++integerDigits;
+			}
+
+			size_t fractionBegin = pos;
+			size_t fractionEnd = pos;
+			if (pos < text.size() && text[pos] == '.')
+			{
+				fractionBegin = ++pos;
+				while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])))
+					++pos;
+				fractionEnd = pos;
+			}
+
+			while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+				++pos;
+
+			if (pos != text.size() || (integerDigits == 0 && fractionBegin == fractionEnd))
+				return false;
+
+			// accumulate the fraction from the last digit: f = (digit + f) / 10
+			fixedpoint value(0.0);
+			for (size_t i = fractionEnd; i-- > fractionBegin;)
+			{
+				value.limbs[FractionLimbs] = static_cast<uint32_t>(text[i] - '0');
+				uint64_t remainder = 0;
+				for (size_t limb = limbCount; limb-- > 0;)
+				{
+					const uint64_t current = (remainder << 32) | value.limbs[limb];
+					value.limbs[limb] = static_cast<uint32_t>(current / 10);
+					remainder = current % 10;
+				}
+			}
+			value.limbs[FractionLimbs] = static_cast<uint32_t>(integer);
+
+			if (negative)
+			{
+				value.negate();
+			}
+			outValue = value;
+			return true;
+		}
+	};
+
+	// Precision used for view centers of deep zooms: 512 fraction bits, enough for zooms beyond 1e140
+	using deepfixed = fixedpoint<16>;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace math
+{
+	// Double mantissa with a 64-bit binary exponent: value = mantissa * 2^exponent, 0.5 <= |mantissa| < 1.
+	// Keeps 53 significant bits at magnitudes far outside the double range, e.g. pixel deltas beyond 1e-308.
+	// Trivially copyable and implicitly constructible from double, so it can be used in vec2<T> and dot.
+	struct floatexp
+	{
+		double mantissa;
+		int64_t exponent;
+
+		// exponent of zero, far below any real value but safe to add to another exponent
+		static constexpr int64_t zeroExponent = INT64_MIN / 4;
+
+		floatexp() = default;
+
+		floatexp(double value)
+		{
+			int e = 0;
+			mantissa = std::frexp(value, &e);
+			exponent = value == 0.0 ? zeroExponent : e;
+		}
+
+		floatexp(double mantissa, int64_t exponent)
+		{
+			*this = normalized(mantissa, exponent);
+		}
+
+		double toDouble() const
+		{
+			// ldexp takes int, anything outside of this range is 0 or inf anyway
+			const int64_t e = exponent < -2000 ? -2000 : (exponent > 2000 ? 2000 : exponent);
+			return std::ldexp(mantissa, static_cast<int>(e));
+		}
+
+		bool isZero() const
+		{
+			return mantissa == 0.0;
+		}
+
+		// Brings `m * 2^e` to the normalized form by rewriting the exponent bits of `m`, frexp only for subnormals
+		static floatexp normalized(double m, int64_t e)
+		{
+			uint64_t bits = 0;
+			std::memcpy(&bits, &m, sizeof(bits));
+			const int64_t biased = static_cast<int64_t>((bits >> 52) & 0x7FF);
+
+			floatexp result;
+			if (biased == 0)
+			{
+				int shift = 0;
+				result.mantissa = std::frexp(m, &shift);
+				result.exponent = m == 0.0 ? zeroExponent : e + shift;
+				return result;
+			}
+
+			bits = (bits & ~(0x7FFull << 52)) | (1022ull << 52);
+			std::memcpy(&result.mantissa, &bits, sizeof(bits));
+			result.exponent = e + biased - 1022;
+			return result;
+		}
+
+		floatexp operator-() const
+		{
+			floatexp result = *this;
+			result.mantissa = -mantissa;
+			return result;
+		}
+
+		friend floatexp operator+(const floatexp& lhs, const floatexp& rhs)
+		{
+			return lhs.exponent >= rhs.exponent ? addAligned(lhs, rhs) : addAligned(rhs, lhs);
+		}
+
+		friend floatexp operator-(const floatexp& lhs, const floatexp& rhs)
+		{
+			return lhs + (-rhs);
+		}
+
+		friend floatexp operator*(const floatexp& lhs, const floatexp& rhs)
+		{
+			return normalized(lhs.mantissa * rhs.mantissa, lhs.exponent + rhs.exponent);
+		}
+
+		friend floatexp operator/(const floatexp& lhs, const floatexp& rhs)
+		{
+			return normalized(lhs.mantissa / rhs.mantissa, lhs.exponent - rhs.exponent);
+		}
+
+		floatexp& operator+=(const floatexp& rhs)
+		{
+			return *this = *this + rhs;
+		}
+
+		floatexp& operator-=(const floatexp& rhs)
+		{
+			return *this = *this - rhs;
+		}
+
+		floatexp& operator*=(const floatexp& rhs)
+		{
+			return *this = *this * rhs;
+		}
+
+		friend bool operator==(const floatexp& lhs, const floatexp& rhs)
+		{
+			return lhs.mantissa == rhs.mantissa && (lhs.exponent == rhs.exponent || lhs.mantissa == 0.0);
+		}
+
+		friend bool operator!=(const floatexp& lhs, const floatexp& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+		friend bool operator<(const floatexp& lhs, const floatexp& rhs)
+		{
+			return (lhs - rhs).mantissa < 0.0;
+		}
+
+		friend bool operator>(const floatexp& lhs, const floatexp& rhs)
+		{
+			return (lhs - rhs).mantissa > 0.0;
+		}
+
+		friend bool operator<=(const floatexp& lhs, const floatexp& rhs)
+		{
+			return !(lhs > rhs);
+		}
+
+		friend bool operator>=(const floatexp& lhs, const floatexp& rhs)
+		{
+			return !(lhs < rhs);
+		}
+
+	private:
+		static floatexp addAligned(const floatexp& larger, const floatexp& smaller)
+		{
+			const int64_t shift = larger.exponent - smaller.exponent;
+			if (shift > 64)
+				return larger;
+
+			// 2^-shift built directly from its exponent bits
+			const uint64_t scaleBits = static_cast<uint64_t>(1023 - shift) << 52;
+			double scale = 0.0;
+			std::memcpy(&scale, &scaleBits, sizeof(scale));
+			return normalized(larger.mantissa + smaller.mantissa * scale, larger.exponent);
+		}
+	};
+
+	inline floatexp sqrt(const floatexp& value)
+	{
+		// keep the halved exponent integral
+		const bool odd = (value.exponent & 1) != 0;
+		return floatexp::normalized(std::sqrt(odd ? value.mantissa * 2.0 : value.mantissa), (value.exponent - (odd ? 1 : 0)) / 2);
+	}
+
+	inline double log(const floatexp& value)
+	{
+		return std::log(value.mantissa) + static_cast<double>(value.exponent) * 0.6931471805599453;
+	}
+
+	inline double toDouble(const floatexp& value)
+	{
+		return value.toDouble();
+	}
+}
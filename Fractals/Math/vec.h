@@ -93,6 +93,12 @@ namespace math
 		return vec2f(static_cast<float>(value.x), static_cast<float>(value.y));
 	}
 
+	// identity for templates written over double and the wide scalar types (floatexp, doubledouble)
+	inline double toDouble(double value)
+	{
+		return value;
+	}
+
 	template<class T>
 	inline T dot(const vec2<T> a, const vec2<T> b)
 	{
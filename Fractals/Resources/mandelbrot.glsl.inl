@@ -12,6 +12,7 @@ uniform vec2	iPosition;
 uniform float	iThreshold;
 uniform int		iMaxIter;
 uniform bool	iColor;
+uniform float	iPaletteOffset;
 
 const int PALETTE_SIZE = 256;
 const int PALETTE[PALETTE_SIZE][3] = {
@@ -139,7 +140,6 @@ float get_iterations_mandelbrot(out vec2 outz, in vec2 c)
 	return iterations;
 }
 
-#define OFFSET_COLOR 84
 void drawColor( out vec4 fragColor, in vec2 fragCoord ) 
 {
 	vec2 z = vec2(0);
@@ -153,7 +153,7 @@ void drawColor( out vec4 fragColor, in vec2 fragCoord )
 	{
 		iter = 0.;
 	}
-	iter += OFFSET_COLOR;
+	iter += iPaletteOffset;
 	float fraction = fract(iter);
 	const int it = int(floor(iter));
 
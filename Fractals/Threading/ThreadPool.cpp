@@ -0,0 +1,171 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	thread_local const ThreadPool* s_currentPool = nullptr;
+	thread_local size_t s_workerIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+	: m_queuedTasks(0)
+	, m_nextQueue(0)
+	, m_stop(false)
+{
+	threadCount = std::max<size_t>(threadCount, 1);
+
+	m_queues.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_queues.emplace_back(new WorkerQueue());
+	}
+
+	m_threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wakeUp.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Submit(Task task)
+{
+	const size_t index = (s_currentPool == this)
+		? s_workerIndex
+		: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+	{
+		WorkerQueue& queue = *m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queuedTasks.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_wakeUp.notify_one();
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+	return m_threads.size();
+}
+
+size_t ThreadPool::GetDefaultThreadCount()
+{
+	const size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+	s_currentPool = this;
+	s_workerIndex = index;
+
+	while (true)
+	{
+		Task task;
+		if (PopLocal(index, task) || Steal(index, task))
+		{
+			m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeUp.wait(lock, [this]()
+		{
+			return m_stop || m_queuedTasks.load(std::memory_order_relaxed) > 0;
+		});
+
+		if (m_stop)
+		{
+			break;
+		}
+	}
+}
+
+bool ThreadPool::PopLocal(size_t index, Task& task)
+{
+	WorkerQueue& queue = *m_queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+	{
+		return false;
+	}
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::Steal(size_t index, Task& task)
+{
+	const size_t count = m_queues.size();
+	for (size_t offset = 1; offset < count; ++offset)
+	{
+		WorkerQueue& queue = *m_queues[(index + offset) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+	: m_pool(pool)
+	, m_pending(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	Wait();
+}
+
+void TaskGroup::Run(ThreadPool::Task task)
+{
+	m_pending.fetch_add(1, std::memory_order_relaxed);
+	m_pool.Submit([this, task = std::move(task)]()
+	{
+		task();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_done.notify_all();
+		}
+	});
+}
+
+void TaskGroup::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]()
+	{
+		return m_pending.load(std::memory_order_acquire) == 0;
+	});
+}
+
+bool TaskGroup::IsDone() const
+{
+	return m_pending.load(std::memory_order_acquire) == 0;
+}
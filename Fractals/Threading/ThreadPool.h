@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long-lived pool of worker threads. Every worker owns a deque of tasks: it pops its own tasks
+// from the back and steals from the front of the other deques when it runs out of work.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	explicit ThreadPool(size_t threadCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Tasks submitted from a worker go to its own deque, other threads spread them round-robin
+	void Submit(Task task);
+
+	size_t GetThreadCount() const;
+
+	// Leaves one hardware thread to the caller (UI), but never returns less than one
+	static size_t GetDefaultThreadCount();
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void WorkerLoop(size_t index);
+
+	bool PopLocal(size_t index, Task& task);
+	bool Steal(size_t index, Task& task);
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeUp;
+
+	std::atomic<int> m_queuedTasks;
+	std::atomic<size_t> m_nextQueue;
+	bool m_stop;
+};
+
+// Tracks a batch of tasks submitted to a ThreadPool so the owner can poll or wait for all of them
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool);
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	void Run(ThreadPool::Task task);
+	void Wait();
+	bool IsDone() const;
+
+private:
+	ThreadPool& m_pool;
+
+	std::atomic<size_t> m_pending;
+	std::mutex m_mutex;
+	std::condition_variable m_done;
+};
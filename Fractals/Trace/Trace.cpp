@@ -0,0 +1,188 @@
+#include "Trace.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Logger/Logger.h"
+
+namespace
+{
+	struct TraceEvent
+	{
+		const char* name;
+		// 'X' - complete, 'i' - instant
+		char phase;
+		Trace::Clock::time_point start;
+		Trace::Clock::duration duration;
+		const char* argName;
+		int64_t argValue;
+	};
+
+	struct ThreadBuffer
+	{
+		std::mutex mutex;
+		std::vector<TraceEvent> events;
+		// tid of the trace, threads are numbered in the order of their first event
+		size_t id = 0;
+		const char* name = nullptr;
+	};
+
+	std::atomic<bool> s_recording(false);
+	// buffers outlive their threads, so events of finished threads are written as well
+	std::mutex s_buffersMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+	std::string s_path;
+	Trace::Clock::time_point s_start;
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		thread_local std::shared_ptr<ThreadBuffer> buffer;
+		if (!buffer)
+		{
+			buffer = std::make_shared<ThreadBuffer>();
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+			buffer->id = s_buffers.size() + 1;
+			s_buffers.push_back(buffer);
+		}
+		return *buffer;
+	}
+
+	void Record(const TraceEvent& event)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.events.push_back(event);
+	}
+
+	double ToMicroseconds(Trace::Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::micro>(duration).count();
+	}
+}
+
+void Trace::Start(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(s_buffersMutex);
+	s_recording.store(false, std::memory_order_relaxed);
+	for (const std::shared_ptr<ThreadBuffer>& buffer : s_buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		buffer->events.clear();
+	}
+	s_path = path;
+	s_start = Clock::now();
+	s_recording.store(true, std::memory_order_release);
+}
+
+bool Trace::Stop()
+{
+	std::lock_guard<std::mutex> lock(s_buffersMutex);
+	if (!s_recording.exchange(false, std::memory_order_acq_rel))
+		return false;
+
+	FILE* file = std::fopen(s_path.c_str(), "w");
+	if (!file)
+	{
+		Logger::Log(LogLevel::ERR, "Trace: failed to open " + s_path);
+		return false;
+	}
+
+	// one process, one track per thread; events are written per thread, the viewers sort them by time
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Fractals\"}}");
+	size_t eventCount = 0;
+	for (const std::shared_ptr<ThreadBuffer>& buffer : s_buffers)
+	{
+		std::vector<TraceEvent> events;
+		const char* name = nullptr;
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+			events.swap(buffer->events);
+			name = buffer->name;
+		}
+
+		if (name)
+		{
+			std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", buffer->id, name);
+		}
+
+		for (const TraceEvent& event : events)
+		{
+			std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"render\",\"ph\":\"%c\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f",
+				event.name, event.phase, buffer->id, ToMicroseconds(event.start - s_start));
+			if (event.phase == 'X')
+			{
+				std::fprintf(file, ",\"dur\":%.3f", ToMicroseconds(event.duration));
+			}
+			else
+			{
+				// instant events are drawn on their thread only
+				std::fprintf(file, ",\"s\":\"t\"");
+			}
+			if (event.argName)
+			{
+				std::fprintf(file, ",\"args\":{\"%s\":%" PRId64 "}", event.argName, event.argValue);
+			}
+			std::fprintf(file, "}");
+		}
+		eventCount += events.size();
+	}
+	std::fprintf(file, "\n]}\n");
+
+	if (std::fclose(file) != 0)
+	{
+		Logger::Log(LogLevel::ERR, "Trace: failed to write " + s_path);
+		return false;
+	}
+	Logger::Log(LogLevel::INFO, "Trace: " + std::to_string(eventCount) + " events written to " + s_path);
+	return true;
+}
+
+bool Trace::IsRecording()
+{
+	return s_recording.load(std::memory_order_relaxed);
+}
+
+void Trace::Complete(const char* name, Clock::time_point start, Clock::time_point end, const char* argName, int64_t argValue)
+{
+	if (IsRecording())
+	{
+		Record(TraceEvent{ name, 'X', start, end - start, argName, argValue });
+	}
+}
+
+void Trace::Instant(const char* name, const char* argName, int64_t argValue)
+{
+	if (IsRecording())
+	{
+		Record(TraceEvent{ name, 'i', Clock::now(), Clock::duration::zero(), argName, argValue });
+	}
+}
+
+void Trace::SetThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+TraceScope::TraceScope(const char* name, const char* argName, int64_t argValue)
+	: m_name(name)
+	, m_argName(argName)
+	, m_argValue(argValue)
+	, m_recording(Trace::IsRecording())
+	, m_start(m_recording ? Trace::Clock::now() : Trace::Clock::time_point())
+{
+}
+
+TraceScope::~TraceScope()
+{
+	if (m_recording)
+	{
+		Trace::Complete(m_name, m_start, Trace::Clock::now(), m_argName, m_argValue);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Timeline of the render lifecycle as Chrome trace-event JSON, opened by chrome://tracing and https://ui.perfetto.dev.
+// Every thread records into its own buffer under a lock only Stop takes as well, so an event costs a clock read
+// and an append; while no trace is recording it costs one relaxed load and can stay in release builds.
+// Names passed to the events must be string literals: only the pointers are kept until the trace is written.
+class Trace
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Starts recording into `path`, a trace already recording is discarded
+	static void Start(const std::string& path);
+	// Writes the events recorded since Start, false when nothing was recording or the file cannot be written
+	static bool Stop();
+	static bool IsRecording();
+
+	// Work on the calling thread from `start` to `end`, with an optional integer argument
+	static void Complete(const char* name, Clock::time_point start, Clock::time_point end, const char* argName = nullptr, int64_t argValue = 0);
+	// A point in time on the calling thread
+	static void Instant(const char* name, const char* argName = nullptr, int64_t argValue = 0);
+	// Label of the calling thread in the timeline instead of its number
+	static void SetThreadName(const char* name);
+};
+
+// Records its lifetime as a complete event when a trace is recording at its construction
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* name, const char* argName = nullptr, int64_t argValue = 0);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* m_name;
+	const char* m_argName;
+	int64_t m_argValue;
+	bool m_recording;
+	Trace::Clock::time_point m_start;
+};
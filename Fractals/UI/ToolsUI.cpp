@@ -1,16 +1,37 @@
 #include "ToolsUI.h"
 #include "Data/RenderConfig.h"
+#include "Data/RenderStats.h"
+#include "Graphics/Palette.h"
+#include "Trace/Trace.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cstdio>
+
 math::vec2d	ToolsUI::s_defaultPosition = math::vec2d(0.0, 0.0);
-float		ToolsUI::s_defaultZoom = 1;
+double		ToolsUI::s_defaultZoom = 1;
 int			ToolsUI::s_defaultMaxIter = 512;
 float		ToolsUI::s_defaultThreshold = 65535;
 bool		ToolsUI::s_defaultColor = true;
+float		ToolsUI::s_defaultPaletteOffset = OFFSET_COLOR;
 bool		ToolsUI::s_defaultUseCPU = false;
+int			ToolsUI::s_defaultTileSize = 64;
+CPUEngine	ToolsUI::s_defaultCPUEngine = CPUEngine::STANDARD;
+bool		ToolsUI::s_defaultBLA = true;
+bool		ToolsUI::s_defaultPeriodicity = true;
+bool		ToolsUI::s_defaultMarianiSilver = false;
+bool		ToolsUI::s_defaultProgressive = false;
+int			ToolsUI::s_defaultTileCacheSize = 256;
+int			ToolsUI::s_defaultMaxSubsamples = 0;
+const char*	ToolsUI::s_tracePath = "fractals_trace.json";
 
 ToolsUI::ToolsUI()
+	: m_deepPositionText()
+	, m_shownDeepPosition()
+	, m_deepPositionTextDirty(true)
 {
 }
 
@@ -48,15 +69,25 @@ void ToolsUI::Update()
 		ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
 		if (ImGui::Begin("Tools", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
 		{
-			ImGui::InputDouble("X", &config->m_position.x, 0.0, 0.0, "%.15f");
+			if (ImGui::InputDouble("X", &config->m_position.x, 0.0, 0.0, "%.15f"))
+			{
+				config->m_deepPosition.x = config->m_position.x;
+			}
 			ImGui::SameLine();
-			ImGui::InputDouble("Y", &config->m_position.y, 0.0, 0.0, "%.15f");
-			ImGui::InputFloat("Zoom", &config->m_zoom, 0.0, 0.0, "%.3f");
+			if (ImGui::InputDouble("Y", &config->m_position.y, 0.0, 0.0, "%.15f"))
+			{
+				config->m_deepPosition.y = config->m_position.y;
+			}
+			ImGui::InputDouble("Zoom", &config->m_zoom, 0.0, 0.0, "%.6g");
 			ImGui::Separator();
 			ImGui::SliderInt("Max Iterations", &config->m_maxIterations, 64, 4096);
 			ImGui::InputFloat("Threshold", &config->m_threshold);
 			ImGui::Separator();
 			ImGui::Checkbox("Enable Color", &config->m_colorEnabled);
+			if (config->m_colorEnabled)
+			{
+				ImGui::SliderFloat("Palette Offset", &config->m_paletteOffset, 0.0f, static_cast<float>(PALETTE_SIZE));
+			}
 			ImGui::Checkbox("Use CPU instead of GPU", &config->m_useCPU);		
 			ImGui::SameLine();
 			ImGui::TextDisabled("(?)");
@@ -68,6 +99,79 @@ void ToolsUI::Update()
 				ImGui::PopTextWrapPos();
 				ImGui::EndTooltip();
 			}
+			if (config->m_useCPU)
+			{
+				static const int tileSizes[] = { 0, 16, 32, 64, 128 };
+				static const char* tileNames[] = { "Interleaved rows", "16x16", "32x32", "64x64", "128x128" };
+				int current = static_cast<int>(std::find(std::begin(tileSizes), std::end(tileSizes), config->m_tileSize) - std::begin(tileSizes));
+				if (ImGui::Combo("Work Units", &current, tileNames, IM_ARRAYSIZE(tileNames)))
+				{
+					config->m_tileSize = tileSizes[current];
+				}
+
+				ImGui::Checkbox("Border Tracing (Mariani-Silver)", &config->m_marianiSilverEnabled);
+				ImGui::Checkbox("Progressive Passes (8/4/2/1)", &config->m_progressiveEnabled);
+				ImGui::SliderInt("Supersampling", &config->m_maxSubsamples, 0, 64, config->m_maxSubsamples > 0 ? "up to %d sub-samples" : "off");
+				ImGui::SameLine();
+				ImGui::TextDisabled("(?)");
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::BeginTooltip();
+					ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+					ImGui::TextUnformatted("Anti-aliasing once the frame is complete: only pixels that differ sharply from a neighbour get jittered sub-samples, flat regions cost nothing.\n\nChanging it keeps the computed frame.");
+					ImGui::PopTextWrapPos();
+					ImGui::EndTooltip();
+				}
+
+				int engine = static_cast<int>(config->m_cpuEngine);
+				static const char* engineNames[] = { "Standard (double)", "Perturbation (deep zoom)", "Double-double (medium zoom)" };
+				if (ImGui::Combo("CPU Engine", &engine, engineNames, IM_ARRAYSIZE(engineNames)))
+				{
+					config->m_cpuEngine = static_cast<CPUEngine>(engine);
+				}
+
+				if (config->m_cpuEngine == CPUEngine::PERTURBATION)
+				{
+					ImGui::Checkbox("Skip Iterations (BLA)", &config->m_blaEnabled);
+					UpdateDeepPosition(*config);
+				}
+				else if (config->m_cpuEngine == CPUEngine::DOUBLE_DOUBLE)
+				{
+					ImGui::Checkbox("Periodicity Check", &config->m_periodicityEnabled);
+					UpdateDeepPosition(*config);
+				}
+				else
+				{
+					ImGui::Checkbox("Periodicity Check", &config->m_periodicityEnabled);
+					ImGui::SliderInt("Tile Cache (MB)", &config->m_tileCacheSize, 0, 2048);
+				}
+
+				if (std::shared_ptr<RenderStats> stats = DataBinder<RenderStats>::GetData())
+				{
+					UpdateRenderStats(*stats);
+				}
+
+				bool recording = Trace::IsRecording();
+				if (ImGui::Checkbox("Record Trace", &recording))
+				{
+					if (recording)
+					{
+						Trace::Start(s_tracePath);
+					}
+					else
+					{
+						Trace::Stop();
+					}
+				}
+				ImGui::SameLine();
+				ImGui::TextDisabled("(?)");
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::BeginTooltip();
+					ImGui::Text("Timeline of the render jobs in %s, written when unchecked.\nOpen it in https://ui.perfetto.dev or chrome://tracing.", s_tracePath);
+					ImGui::EndTooltip();
+				}
+			}
 
 			if (ImGui::Button("Reset"))
 			{
@@ -87,7 +191,101 @@ void ToolsUI::Reset()
 		config->m_maxIterations = s_defaultMaxIter;
 		config->m_threshold = s_defaultThreshold;
 		config->m_colorEnabled = s_defaultColor;
+		config->m_paletteOffset = s_defaultPaletteOffset;
 		config->m_useCPU = s_defaultUseCPU;
+		config->m_tileSize = s_defaultTileSize;
+		config->m_cpuEngine = s_defaultCPUEngine;
+		config->m_blaEnabled = s_defaultBLA;
+		config->m_periodicityEnabled = s_defaultPeriodicity;
+		config->m_marianiSilverEnabled = s_defaultMarianiSilver;
+		config->m_progressiveEnabled = s_defaultProgressive;
+		config->m_tileCacheSize = s_defaultTileCacheSize;
+		config->m_maxSubsamples = s_defaultMaxSubsamples;
+		config->m_deepPosition = math::vec2<math::deepfixed>(s_defaultPosition.x, s_defaultPosition.y);
+	}
+}
+
+
+void ToolsUI::UpdateDeepPosition(RenderConfig& config)
+{
+	// refresh the text only when the position changed outside of these fields, so typing is not overwritten
+	if (m_deepPositionTextDirty || !(m_shownDeepPosition == config.m_deepPosition))
+	{
+		m_deepPositionTextDirty = false;
+		m_shownDeepPosition = config.m_deepPosition;
+		const int digits = std::clamp(static_cast<int>(std::log10(std::max(config.m_zoom, 1.0))) + 10, 15, 150);
+		for (size_t i = 0; i < 2; ++i)
+		{
+			const std::string text = config.m_deepPosition.raw[i].toString(digits);
+			std::snprintf(m_deepPositionText[i], sizeof(m_deepPositionText[i]), "%s", text.c_str());
+		}
+	}
+
+	const char* labels[] = { "Deep X", "Deep Y" };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (ImGui::InputText(labels[i], m_deepPositionText[i], sizeof(m_deepPositionText[i]), ImGuiInputTextFlags_EnterReturnsTrue))
+		{
+			math::deepfixed value;
+			if (math::deepfixed::fromString(m_deepPositionText[i], value))
+			{
+				config.m_deepPosition.raw[i] = value;
+				config.m_position.raw[i] = value.toDouble();
+			}
+			m_deepPositionTextDirty = true;
+		}
 	}
 }
 
+void ToolsUI::UpdateRenderStats(const RenderStats& stats)
+{
+	if (!ImGui::CollapsingHeader("Render Statistics"))
+		return;
+
+	if (stats.m_workerBusyTimes.empty())
+	{
+		ImGui::TextDisabled("No render yet");
+		return;
+	}
+
+	const double pixelCount = static_cast<double>(stats.m_resolution.x) * stats.m_resolution.y;
+	ImGui::Text("%dx%d, %s", stats.m_resolution.x, stats.m_resolution.y, stats.m_finished ? "done" : "rendering");
+	ImGui::Text("Iterations: %.4g (%.1f per pixel)", static_cast<double>(stats.m_iterations), pixelCount > 0.0 ? stats.m_iterations / pixelCount : 0.0);
+	ImGui::Text("Bulb pixels: %zu (%.1f%%)", stats.m_bulbPixels, pixelCount > 0.0 ? 100.0 * stats.m_bulbPixels / pixelCount : 0.0);
+	ImGui::Text("Max iteration pixels: %zu (%.1f%%)", stats.m_maxIterationPixels, pixelCount > 0.0 ? 100.0 * stats.m_maxIterationPixels / pixelCount : 0.0);
+	ImGui::Text("Periodic pixels: %zu", stats.m_periodicPixels);
+	if (stats.m_refinedPixels > 0)
+	{
+		ImGui::Text("Refined pixels: %zu (%.1f%%), %zu sub-samples", stats.m_refinedPixels, pixelCount > 0.0 ? 100.0 * stats.m_refinedPixels / pixelCount : 0.0, stats.m_subsamples);
+	}
+	if (stats.m_cacheTiles > 0 || stats.m_cacheHits + stats.m_cacheMisses > 0)
+	{
+		ImGui::Text("Tile cache: %zu hits, %zu misses, %zu pixels (%.1f%%)", stats.m_cacheHits, stats.m_cacheMisses, stats.m_cachedPixels, pixelCount > 0.0 ? 100.0 * stats.m_cachedPixels / pixelCount : 0.0);
+		ImGui::Text("Tile cache size: %zu tiles, %.1f MB", stats.m_cacheTiles, stats.m_cacheBytes / 1048576.0);
+	}
+	ImGui::Separator();
+	if (stats.m_firstPixelTime < 0.0)
+	{
+		ImGui::Text("First pixel: -");
+	}
+	else
+	{
+		ImGui::Text("First pixel: %.2f ms", stats.m_firstPixelTime);
+	}
+	ImGui::Text("%s: %.2f ms", stats.m_finished ? "Completion" : "Elapsed", stats.m_elapsedTime);
+	if (stats.m_finished)
+	{
+		ImGui::Text("Throughput: %.1f Mpix/s", stats.GetMegapixelsPerSecond());
+	}
+
+	// busy time of every worker against the elapsed time, a short bar is a worker left waiting
+	for (size_t i = 0; i < stats.m_workerBusyTimes.size(); ++i)
+	{
+		const double busyTime = stats.m_workerBusyTimes[i];
+		char label[64] = {};
+		std::snprintf(label, sizeof(label), "%.1f ms", busyTime);
+		ImGui::ProgressBar(stats.m_elapsedTime > 0.0 ? static_cast<float>(busyTime / stats.m_elapsedTime) : 0.0f, ImVec2(200.0f, 0.0f), label);
+		ImGui::SameLine();
+		ImGui::Text("Worker %zu", i);
+	}
+}
@@ -2,10 +2,13 @@
 
 #include "Data/DataBinder.h"
 #include "Math/vec.h"
+#include "Math/fixedpoint.h"
 
 struct RenderConfig;
+struct RenderStats;
+enum class CPUEngine;
 
-class ToolsUI : public DataBinder<RenderConfig>
+class ToolsUI : public DataBinder<RenderConfig>, public DataBinder<RenderStats>
 {
 public:
 	ToolsUI();
@@ -15,11 +18,27 @@ public:
 	void Reset();
 
 private:
+	void UpdateDeepPosition(RenderConfig& config);
+	void UpdateRenderStats(const RenderStats& stats);
+
+	char m_deepPositionText[2][192];
+	math::vec2<math::deepfixed> m_shownDeepPosition;
+	bool m_deepPositionTextDirty;
 
 	static math::vec2d	s_defaultPosition;
-	static float		s_defaultZoom;
+	static double		s_defaultZoom;
 	static int			s_defaultMaxIter;
 	static float		s_defaultThreshold;
 	static bool			s_defaultColor;
+	static float		s_defaultPaletteOffset;
 	static bool			s_defaultUseCPU;
+	static int			s_defaultTileSize;
+	static CPUEngine	s_defaultCPUEngine;
+	static bool			s_defaultBLA;
+	static bool			s_defaultPeriodicity;
+	static bool			s_defaultMarianiSilver;
+	static bool			s_defaultProgressive;
+	static int			s_defaultTileCacheSize;
+	static int			s_defaultMaxSubsamples;
+	static const char*	s_tracePath;
 };
\ No newline at end of file
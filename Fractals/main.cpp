@@ -1,5 +1,6 @@
 #include "Logger/Logger.h"
 #include "Logger/ConsoleLogger.h"
+#include "Trace/Trace.h"
 
 #include "Application/FractalsApplication.h"
 
@@ -9,12 +10,15 @@ int main()
 {
 	Logger::MakeInstance();
 	Logger::AddLoger(new ConsoleLogger());
+	Trace::SetThreadName("Main thread");
 
 	FractalsApplication app;
 	app.Init();
 
 	const int result = app.Run();
 
+	// a trace still recording at exit is written as well
+	Trace::Stop();
 	Logger::FreeInstance();
 
 	return result;